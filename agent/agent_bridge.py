@@ -7,11 +7,42 @@
 #
 #   SCHED_LOG_START
 #   TIMESTAMP:<ticks>
-#   PROC:<pid>,<state>,<cpu_ticks>,<wait_ticks>,<io_count>,<recent_cpu>
+#   POLICY:<name>,<slice>
+#   STARVE:<tick>,<pid>,<waited>,<advice>
+#   ...
+#   PROC:<pid>,<state>,<cpu_ticks>,<wait_ticks>,<io_count>,<recent_cpu>,<flags>,<lastcpu>,<migrations>,<group>,<lockwait>,<inversions>,<nice>,<vcsw>,<ivcsw>,<timeslice>,<gang>,<maxwait>
 #   PROC:...
 #   ...
+#   GROUP:<gid>,<share>,<nproc>,<cpu_ticks>,<wait_ticks>
+#   ...
+#   GANG:<id>,<nmembers>,<skew>
+#   ...
 #   SCHED_LOG_END
 #
+# <flags> is a bitmask (SCHED_FLAG_* in kernel/proc.h); bit 0 marks a
+# kernel thread, which has a negative pid and is never advised, bit 1
+# a clone()d user thread sharing another pid's memory, and bit 2 a process
+# in the real-time (EDF) class, which the kernel already runs first. <lastcpu> is the
+# hart the process last ran on (-1 if none) and <migrations> counts moves
+# between harts. <group> is the process's scheduling group; the kernel
+# shares CPU between groups by <share> before sharing it within a group,
+# and GROUP lines total each group's CPU and wait. <lockwait> is ticks spent
+# blocked on sleeplocks (kept apart from <io_count>) and <inversions> counts
+# such waits behind a lower-priority holder. <nice> is the setpriority()
+# value, -20 (favoured) .. 19 (background). <vcsw> and <ivcsw> count
+# switches away to sleep or yield() and by preemption, and <timeslice> is the
+# process's own quantum in ticks (0 = the policy's <slice>). <gang> is the
+# process's gang (0 if none): harts run a gang's members side by side, and
+# GANG lines give each gang's size and the <skew> in ticks between its first
+# and last member finishing (-1 until a round completes). <maxwait> is the
+# longest the process has been runnable without running. Each STARVE line is
+# a time the kernel's starvation guard ran <pid> after <waited> ticks,
+# overriding whatever <advice> was pending (0 if none, -gang for a gang);
+# the agent counts those that overrode advice. POLICY names
+# the kernel's current scheduling policy; under "rr" advice is ignored,
+# so none is sent. Older kernels omit trailing fields and the POLICY and
+# GROUP lines, and extra trailing fields are ignored.
+#
 # where `ticks` is the kernel's global timer tick counter and `state`
 # is the enum value from xv6:
 #   UNUSED   == 0
@@ -23,7 +54,15 @@
 #
 # Advice format (written by this agent):
 #
-#   ADVICE:PID=<pid> TS=<ticks> V=1
+#   ADVICE:PID=<pid> TS=<ticks> V=1 [SLICE=<ticks>]
+#   ADVICE:GANG=<gang> TS=<ticks> V=1
+#
+# The GANG form is sent instead when the chosen process is in a gang with
+# other runnable members, so the kernel starts the whole gang together.
+# SLICE, when present, also sets that process's time slice: mostly
+# preempted (CPU-bound) processes get SLICE_LONG to save context switches,
+# the rest go back to the policy's default (SLICE=0). It's only sent when
+# that would change what the kernel reports.
 #
 # These lines are appended to llm_advice.txt and also written to
 # llm_advice.fifo so that console_mux.py can inject them into QEMU's stdin.
@@ -36,7 +75,7 @@ import errno
 import requests
 import subprocess
 from dataclasses import dataclass
-from typing import List, Optional, Tuple
+from typing import Dict, List, Optional, Tuple
 from pathlib import Path
 
 #### Paths (absolute, CWD-agnostic) ####
@@ -106,10 +145,24 @@ INTERVAL = float(os.getenv("LLM_AGENT_INTERVAL", 1.0))
 W_WAIT   = float(os.getenv("LLM_AGENT_W_WAIT",   "1.0"))
 W_IO     = float(os.getenv("LLM_AGENT_W_IO",     "1.0"))
 W_RECENT = float(os.getenv("LLM_AGENT_W_RECENT", "1.2"))
+W_NICE   = float(os.getenv("LLM_AGENT_W_NICE",   "5.0"))
+
+# Time slice (ticks) for CPU-bound processes, and how many preemptions per
+# voluntary switch make a process count as CPU-bound.
+SLICE_LONG     = int(os.getenv("LLM_AGENT_SLICE_LONG", "4"))
+CPU_BOUND_RATIO = float(os.getenv("LLM_AGENT_CPU_BOUND_RATIO", "4.0"))
 
 # Optional cap on how many runnable processes we include in the LLM prompt.
 MAX_PROCS_IN_PROMPT = int(os.getenv("LLM_AGENT_MAX_PROCS", "64"))
 
+# Bits in the PROC <flags> field (must match kernel/proc.h).
+SCHED_FLAG_KTHREAD = 0x1
+SCHED_FLAG_THREAD = 0x2
+SCHED_FLAG_RT = 0x4
+
+# Kernel policy (POLICY: line) under which advice is ignored.
+POLICY_NO_ADVICE = "rr"
+
 #### Data Model ####
 @dataclass
 class ProcessStats:
@@ -123,6 +176,18 @@ class ProcessStats:
         wait_ticks  (int): Time spent waiting to be scheduled.
         io_count    (int): Count of I/O-style blocking events.
         recent_cpu  (int): Recent CPU usage (e.g., ticks in the latest window).
+        flags       (int): SCHED_FLAG_* bits (0 if the kernel didn't report any).
+        last_cpu    (int): Hart the process last ran on (-1 if unknown).
+        migrations  (int): Times it was dispatched on a different hart.
+        group       (int): Scheduling group id.
+        lock_wait   (int): Ticks spent waiting for sleeplocks.
+        inversions  (int): Sleeplock waits behind a lower-priority holder.
+        nice        (int): setpriority() value, -20 .. 19.
+        vcsw        (int): Switches away to sleep or yield() (voluntary).
+        ivcsw       (int): Switches away by preemption (involuntary).
+        timeslice   (int): Own quantum in ticks (0 = the policy's).
+        gang        (int): Gang id (0 if none).
+        max_wait    (int): Longest stretch runnable without running.
     """
     pid: int
     state: int
@@ -130,6 +195,63 @@ class ProcessStats:
     wait_ticks: int
     io_count: int
     recent_cpu: int
+    flags: int = 0
+    last_cpu: int = -1
+    migrations: int = 0
+    group: int = 0
+    lock_wait: int = 0
+    inversions: int = 0
+    nice: int = 0
+    vcsw: int = 0
+    ivcsw: int = 0
+    timeslice: int = 0
+    gang: int = 0
+    max_wait: int = 0
+
+    @property
+    def is_kthread(self) -> bool:
+        return bool(self.flags & SCHED_FLAG_KTHREAD)
+
+    @property
+    def is_thread(self) -> bool:
+        return bool(self.flags & SCHED_FLAG_THREAD)
+
+    @property
+    def is_rt(self) -> bool:
+        return bool(self.flags & SCHED_FLAG_RT)
+
+@dataclass
+class GroupStats:
+    """
+    Per-scheduling-group totals from a GROUP line.
+
+    Attributes:
+        gid         (int): Group id.
+        share       (int): Relative CPU share (kernel default 100).
+        nproc       (int): Live member processes.
+        cpu_ticks   (int): Total CPU ticks used by members.
+        wait_ticks  (int): Total ticks members spent runnable but waiting.
+    """
+    gid: int
+    share: int
+    nproc: int
+    cpu_ticks: int
+    wait_ticks: int
+
+@dataclass
+class GangStats:
+    """
+    Per-gang figures from a GANG line.
+
+    Attributes:
+        gang        (int): Gang id.
+        nmembers    (int): Live member processes.
+        skew        (int): Ticks between the first and last member finishing
+                           in the last complete round (-1 if none).
+    """
+    gang: int
+    nmembers: int
+    skew: int
 
 #### Agent ####
 class LLMSchedulerAgent:
@@ -156,6 +278,21 @@ class LLMSchedulerAgent:
         # Log reading cursor (tracks how many bytes we've already consumed).
         self.last_size = 0
 
+        # Scheduling groups from the most recently parsed block.
+        self.groups: Dict[int, GroupStats] = {}
+
+        # Gangs from the most recently parsed block.
+        self.gangs: Dict[int, GangStats] = {}
+
+        # Starvation guard events seen so far, and how many of them
+        # overrode pending advice (the LLM would have starved something).
+        self.starvations = 0
+        self.starved_despite_advice = 0
+
+        # Kernel scheduling policy from the most recently parsed block
+        # (None if the kernel doesn't report one).
+        self.policy: Optional[str] = None
+
         # Lifetime flag controlled by signal handlers.
         self.running = True
 
@@ -171,7 +308,7 @@ class LLMSchedulerAgent:
         print(f"[agent] Advice log  : {self.advice_file}")
         print(f"[agent] Advice FIFO : {self.advice_fifo_path} (optional)")
         print(f"[agent] Interval    : {self.interval}s")
-        print(f"[agent] Weights     : WAIT={W_WAIT} IO={W_IO} RECENT={W_RECENT}")
+        print(f"[agent] Weights     : WAIT={W_WAIT} IO={W_IO} RECENT={W_RECENT} NICE={W_NICE}")
         print(f"[agent] MaxProcs    : {MAX_PROCS_IN_PROMPT}")
         print(f"[agent] Retries     : {RETRIES} (sleep {RETRY_SLEEP_MS}ms between)")
         print(f"[agent] LLM opts    : temp={LLM_TEMP} num_predict={LLM_NUM_PRED}\n")
@@ -184,7 +321,9 @@ class LLMSchedulerAgent:
         """
         Signal handler used to stop the main loop gracefully.
         """
-        print("\n[agent] Shutting down...\n")
+        print("\n[agent] Shutting down...")
+        print(f"[agent] Starvation guard fired {self.starvations} times, "
+              f"{self.starved_despite_advice} overriding advice\n")
         self.running = False
 
     #### Internal implementation ####
@@ -224,6 +363,10 @@ class LLMSchedulerAgent:
 
             log_ts: Optional[int] = None
             processes: List[ProcessStats] = []
+            groups: Dict[int, GroupStats] = {}
+            gangs: Dict[int, GangStats] = {}
+            starved: List[Tuple[int, ...]] = []
+            policy: Optional[str] = None
 
             # Parse header and process lines.
             for line in last.splitlines():
@@ -234,17 +377,52 @@ class LLMSchedulerAgent:
                         log_ts = None
                 elif line.startswith("PROC:"):
                     # Order must match the kernel's printf():
-                    #   PROC:%d,%d,%d,%d,%d,%d
-                    #        pid,state,cpu,wait,io,recent
+                    #   PROC:%d,%d,%d,%d,%d,%d,%d,%d,%d,%d,%d,%d,%d,%d,%d,%d,%d,%d
+                    #        pid,state,cpu,wait,io,recent,flags,lastcpu,migrations,group,
+                    #        lockwait,inversions,nice,vcsw,ivcsw,timeslice,gang,maxwait
                     p = line[5:].split(",")
-                    if len(p) == 6:
+                    if len(p) >= 6:
+                        try:
+                            processes.append(ProcessStats(*map(int, p[:18])))
+                        except ValueError:
+                            continue
+                elif line.startswith("POLICY:"):
+                    policy = line[7:].split(",")[0].strip()
+                elif line.startswith("GROUP:"):
+                    g = line[6:].split(",")
+                    if len(g) >= 5:
+                        try:
+                            gs = GroupStats(*map(int, g[:5]))
+                            groups[gs.gid] = gs
+                        except ValueError:
+                            continue
+                elif line.startswith("STARVE:"):
+                    s = line[7:].split(",")
+                    if len(s) >= 4:
+                        try:
+                            starved.append(tuple(map(int, s[:4])))
+                        except ValueError:
+                            continue
+                elif line.startswith("GANG:"):
+                    g = line[5:].split(",")
+                    if len(g) >= 3:
                         try:
-                            processes.append(ProcessStats(*map(int, p)))
+                            gg = GangStats(*map(int, g[:3]))
+                            gangs[gg.gang] = gg
                         except ValueError:
                             continue
 
             if log_ts is None or not processes:
                 return None
+            self.groups = groups
+            self.gangs = gangs
+            self.policy = policy
+            for tick, pid, waited, advice in starved:
+                self.starvations += 1
+                if advice != 0:
+                    self.starved_despite_advice += 1
+                    print(f"[agent] Kernel ran starving PID={pid} after {waited} ticks "
+                          f"@TS={tick}, overriding advice {advice}")
 
             print(f"[agent] Parsed {len(processes)} processes from scheduler log @TS={log_ts}")
             return log_ts, processes
@@ -261,7 +439,7 @@ class LLMSchedulerAgent:
         Filter to only "interesting" processes for scheduling advice.
 
         Primary policy:
-          - user processes (pid > 3),
+          - user processes (pid > 3, not kernel threads or real-time),
           - in RUNNABLE or RUNNING state (3 or 4).
 
         Fallback:
@@ -271,7 +449,7 @@ class LLMSchedulerAgent:
         # Primary: RUNNABLE or RUNNING user processes.
         primary = [
             p for p in procs
-            if p.pid > 3 and p.state in (3, 4)
+            if p.pid > 3 and not p.is_kthread and not p.is_rt and p.state in (3, 4)
         ]
         if primary:
             return primary
@@ -279,7 +457,7 @@ class LLMSchedulerAgent:
         # Fallback: any non-zombie, non-unused user process.
         fallback = [
             p for p in procs
-            if p.pid > 3 and 1 <= p.state <= 4
+            if p.pid > 3 and not p.is_kthread and not p.is_rt and 1 <= p.state <= 4
         ]
         return fallback
 
@@ -310,6 +488,12 @@ class LLMSchedulerAgent:
             "   HIGHER IO (more interactive / I/O-bound),",
             "   and LOWER RECENT CPU (to avoid hogs and balance CPU).",
             "   Avoid starvation: if any process has much larger WAIT, it should be preferred.",
+            "   High LOCKWAIT means a process is blocked on kernel locks, not doing I/O.",
+            "5) All else equal, prefer FEWER MIGRATIONS (keeps caches warm on its LASTCPU).",
+            "6) Each process is in a GROUP. If a group's WAIT per SHARE is much higher",
+            "   than the others', prefer a process from that group.",
+            "7) Prefer LOWER NICE: negative NICE was asked for more CPU, positive for less.",
+            "8) Processes with the same GANG run together; choosing one starts them all.",
             "",
             "Processes:",
         ]
@@ -317,9 +501,22 @@ class LLMSchedulerAgent:
         for p in ready:
             lines.append(
                 f"PID={p.pid} CPU={p.cpu_ticks} WAIT={p.wait_ticks} "
-                f"IO={p.io_count} RECENT={p.recent_cpu}"
+                f"IO={p.io_count} RECENT={p.recent_cpu} "
+                f"LASTCPU={p.last_cpu} MIGRATIONS={p.migrations} GROUP={p.group} "
+                f"LOCKWAIT={p.lock_wait} NICE={p.nice}"
+                + (f" GANG={p.gang}" if p.gang else "")
+                + (" THREAD" if p.is_thread else "")
             )
 
+        if self.groups:
+            lines.append("")
+            lines.append("Groups:")
+            for g in sorted(self.groups.values(), key=lambda x: x.gid):
+                lines.append(
+                    f"GROUP={g.gid} SHARE={g.share} NPROC={g.nproc} "
+                    f"CPU={g.cpu_ticks} WAIT={g.wait_ticks}"
+                )
+
         lines.append("")
         lines.append("Return ONLY one line like this: PID:3")
 
@@ -392,6 +589,7 @@ class LLMSchedulerAgent:
 
         def score(p: ProcessStats) -> Tuple[float, int]:
             s = (W_WAIT * p.wait_ticks) + (W_IO * p.io_count) - (W_RECENT * p.recent_cpu)
+            s -= W_NICE * p.nice
             jitter = (hash(p.pid) % 7) * 0.01
             return s + jitter, -p.cpu_ticks
 
@@ -399,6 +597,25 @@ class LLMSchedulerAgent:
         print(f"[agent] Fallback chose PID={best.pid}")
         return best.pid
 
+    def _slice_for(self, p: ProcessStats) -> Optional[int]:
+        """
+        Time slice to advise for p, or None to leave it alone.
+
+        Mostly preempted processes are CPU-bound and get SLICE_LONG;
+        anything else goes back to the policy default (0).
+        """
+        want = SLICE_LONG if p.ivcsw > CPU_BOUND_RATIO * max(1, p.vcsw) else 0
+        return None if want == p.timeslice else want
+
+    def _gang_for(self, p: ProcessStats, runnable: List[ProcessStats]) -> Optional[int]:
+        """
+        Gang to advise instead of p, if p is in one with other runnable members.
+        """
+        if p.gang == 0:
+            return None
+        n = sum(1 for q in runnable if q.gang == p.gang)
+        return p.gang if n > 1 else None
+
     def _write_fifo(self, line: str) -> None:
         """
         Best-effort write of an advice line into the FIFO used by console_mux.py.
@@ -419,18 +636,26 @@ class LLMSchedulerAgent:
         finally:
             os.close(fd)
 
-    def _write(self, pid: int, ts: int):
+    def _write(self, pid: int, ts: int, slice_: Optional[int] = None,
+               gang: Optional[int] = None):
         """
         Append an advice line to the advice file and mirror it to the FIFO.
 
         Format:
-            ADVICE:PID=<pid> TS=<timestamp> V=1
+            ADVICE:PID=<pid> TS=<timestamp> V=1 [SLICE=<ticks>]
+            ADVICE:GANG=<gang> TS=<timestamp> V=1      (if gang is given)
         """
         try:
             if self._last_advised_ts == ts and pid == self._last_sent_pid:
                 return
 
-            line = f"ADVICE:PID={pid} TS={ts} V=1\n"
+            if gang is not None:
+                line = f"ADVICE:GANG={gang} TS={ts} V=1"
+            else:
+                line = f"ADVICE:PID={pid} TS={ts} V=1"
+            if slice_ is not None and gang is None:
+                line += f" SLICE={slice_}"
+            line += "\n"
 
             # Log file (for analysis / debugging).
             with open(self.advice_file, "a", encoding="utf-8") as f:
@@ -494,6 +719,11 @@ class LLMSchedulerAgent:
                     time.sleep(self.interval)
                     continue
 
+                # The kernel's policy would throw advice away.
+                if self.policy == POLICY_NO_ADVICE:
+                    time.sleep(self.interval)
+                    continue
+
                 runnable = self._runnable(processes)
                 if not runnable:
                     time.sleep(self.interval)
@@ -501,7 +731,7 @@ class LLMSchedulerAgent:
 
                 # If there's only one candidate, just pick it.
                 if len(runnable) == 1:
-                    self._write(runnable[0].pid, log_ts)
+                    self._write(runnable[0].pid, log_ts, self._slice_for(runnable[0]))
                     time.sleep(self.interval)
                     continue
 
@@ -520,7 +750,9 @@ class LLMSchedulerAgent:
                     chosen_pid = self._fallback_choice(processes)
 
                 if chosen_pid is not None:
-                    self._write(chosen_pid, log_ts)
+                    chosen = next(p for p in processes if p.pid == chosen_pid)
+                    self._write(chosen_pid, log_ts, self._slice_for(chosen),
+                                self._gang_for(chosen, runnable))
 
             time.sleep(self.interval)
 
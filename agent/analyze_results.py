@@ -27,7 +27,7 @@ def parse_sched_log(path: Path):
 
         SCHED_LOG_START
         TIMESTAMP:<ticks>
-        PROC:<pid>,<state>,<cpu_ticks>,<wait_ticks>,<io_count>,<recent_cpu>
+        PROC:<pid>,<state>,<cpu_ticks>,<wait_ticks>,<io_count>,<recent_cpu>[,<flags>,<lastcpu>,<migrations>,<group>,<lockwait>,<inversions>,<nice>,<vcsw>,<ivcsw>,<timeslice>,<gang>,<maxwait>...]
         ...
         SCHED_LOG_END
 
@@ -96,7 +96,7 @@ def parse_sched_log(path: Path):
             if not line.startswith("PROC:"):
                 continue
             parts = line[5:].split(",")  # drop "PROC:" prefix
-            if len(parts) != 6:
+            if len(parts) < 6:
                 continue
 
             try:
@@ -109,7 +109,8 @@ def parse_sched_log(path: Path):
             except ValueError:
                 continue
 
-            # Skip the xv6 init / shell processes (pid 1–2)
+            # Skip the xv6 init / shell processes (pid 1–2) and
+            # kernel threads (negative pids)
             if pid <= 2:
                 continue
 
@@ -14,19 +14,61 @@
 #   - Reads from the named pipe (FIFO) where agent_bridge.py writes
 #     ADVICE:PID=... lines.
 #   - Writes both streams to stdout, which is then piped into QEMU's stdin.
+#
+# Replay mode feeds a recording made by sched_log_splitter.py --record
+# instead of live advice, so no agent or FIFO is needed:
+#
+#   python3 ../agent/console_mux.py --replay ../shared/advice_record.txt | qemu-system-riscv64 ...
+#
+# Each recorded "<tick> <advice>" line is sent as "<advice> AT=<tick>"
+# a little (--lead ticks) before QEMU's clock reaches that tick, and
+# llmhelper holds it until the guest's uptime() does. Guest ticks
+# never run ahead of the host clock, so nothing arrives late as long
+# as console_mux and QEMU start together.
 
+import argparse
 import sys
 import time
 import selectors
 from pathlib import Path
 
+# One guest timer tick (kernel/trap.c: 1000000 cycles at 10 MHz).
+TICK_S = 0.1
+
+
+def load_replay(path: Path) -> list:
+    """Read "<tick> <advice>" lines into [(tick, advice line with AT=)]."""
+    feed = []
+    with path.open("r", encoding="utf-8") as f:
+        for line in f:
+            parts = line.split(None, 1)
+            if len(parts) != 2 or not parts[0].isdigit():
+                continue
+            tick = int(parts[0])
+            feed.append((tick, f"{parts[1].strip()} AT={tick}\n"))
+    feed.sort(key=lambda t: t[0])
+    return feed
+
 
 def main() -> None:
-    if len(sys.argv) != 2:
-        print(f"Usage: {sys.argv[0]} /path/to/llm_advice.fifo", file=sys.stderr)
-        sys.exit(1)
+    ap = argparse.ArgumentParser(description="Merge keyboard input and advice into QEMU's stdin")
+    ap.add_argument("fifo", nargs="?", help="FIFO agent_bridge.py writes ADVICE lines to")
+    ap.add_argument("--replay", metavar="FILE",
+                    help="feed advice recorded by sched_log_splitter.py --record")
+    ap.add_argument("--lead", type=int, default=10,
+                    help="send replayed advice this many ticks early (default 10)")
+    args = ap.parse_args()
+    if args.fifo is None and args.replay is None:
+        ap.error("need a FIFO or --replay FILE")
+
+    feed = load_replay(Path(args.replay)) if args.replay else []
+    start = time.monotonic()
+
+    if args.fifo is None:
+        replay_only(feed, args.lead, start)
+        return
 
-    fifo_path = Path(sys.argv[1]).resolve()
+    fifo_path = Path(args.fifo).resolve()
 
     if not fifo_path.exists():
         print(f"[console_mux] FIFO does not exist: {fifo_path}", file=sys.stderr)
@@ -48,7 +90,8 @@ def main() -> None:
 
     try:
         while True:
-            events = sel.select()
+            feed = send_due(feed, args.lead, start)
+            events = sel.select(timeout=next_timeout(feed, args.lead, start))
             for key, _ in events:
                 if key.fileobj is sys.stdin:
                     # Interactive input from the user: read a whole line so shell
@@ -82,5 +125,42 @@ def main() -> None:
         fifo_w.close()
 
 
+def next_timeout(feed: list, lead: int, start: float):
+    """Seconds until the next replayed line is due, or None."""
+    if not feed:
+        return None
+    return max(0.0, start + (feed[0][0] - lead) * TICK_S - time.monotonic())
+
+
+def send_due(feed: list, lead: int, start: float) -> list:
+    """Write the replayed lines that are due; return the rest."""
+    while feed and next_timeout(feed, lead, start) == 0.0:
+        sys.stdout.write(feed[0][1])
+        sys.stdout.flush()
+        feed = feed[1:]
+    return feed
+
+
+def replay_only(feed: list, lead: int, start: float) -> None:
+    """Replay without a FIFO: keyboard lines and the recording."""
+    sel = selectors.DefaultSelector()
+    sel.register(sys.stdin, selectors.EVENT_READ)
+    stdin_open = True
+    while stdin_open or feed:
+        feed = send_due(feed, lead, start)
+        if not stdin_open:
+            if feed:
+                time.sleep(next_timeout(feed, lead, start))
+            continue
+        for key, _ in sel.select(timeout=next_timeout(feed, lead, start)):
+            line = sys.stdin.readline()
+            if line == "":
+                sel.unregister(sys.stdin)
+                stdin_open = False
+                break
+            sys.stdout.write(line)
+            sys.stdout.flush()
+
+
 if __name__ == "__main__":
     main()
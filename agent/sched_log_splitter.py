@@ -10,8 +10,14 @@
 #   SCHED_LOG_END
 # and appends them to shared/sched_log.txt, while *not* printing those
 # blocks to stdout. Everything else is forwarded to stdout unchanged.
+#
+# With --record FILE it also appends each piece of advice llmhelper
+# reports applying ("llmhelper: applied at tick <t>: <advice>") to
+# FILE as "<t> <advice>", for console_mux.py --replay.
 
+import argparse
 import os
+import re
 import sys
 from pathlib import Path
 
@@ -21,10 +27,29 @@ SHARED = ROOT / "shared"
 
 LOG_PATH = SHARED / "sched_log.txt"
 
+APPLIED_RE = re.compile(r"llmhelper: applied at tick (\d+): (ADVICE:\S.*?)\s*$")
+AT_RE = re.compile(r"\s+AT=\d+")
+
+def record(rec, line: str) -> None:
+    """Append the advice on an llmhelper "applied" line to rec."""
+    m = APPLIED_RE.search(line)
+    if not m:
+        return
+    tick, advice = m.groups()
+    # A replayed run records cleanly again: drop the AT= it was fed.
+    rec.write(f"{tick} {AT_RE.sub('', advice)}\n")
+    rec.flush()
+
 def main() -> None:
+    ap = argparse.ArgumentParser(description="Split QEMU output into console and sched_log.txt")
+    ap.add_argument("--record", metavar="FILE",
+                    help="also save applied advice with its guest tick to FILE")
+    args = ap.parse_args()
+
     SHARED.mkdir(exist_ok=True)
     # Ensure the log file exists so other tools can tail it.
     LOG_PATH.touch(exist_ok=True)
+    rec = open(args.record, "w", encoding="utf-8") if args.record else None
 
     in_block = False
     block_lines: list[str] = []
@@ -39,6 +64,8 @@ def main() -> None:
                 # Normal console output; pass it through.
                 sys.stdout.write(line)
                 sys.stdout.flush()
+                if rec:
+                    record(rec, line)
             else:
                 # Prefix before the marker (e.g., "$ ") should still go to the console.
                 prefix = line[:start_idx]
@@ -69,6 +96,8 @@ def main() -> None:
 
     # If stdin closes, just exit.
     sys.stdout.flush()
+    if rec:
+        rec.close()
 
 if __name__ == "__main__":
     main()
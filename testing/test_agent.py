@@ -15,14 +15,23 @@ def _write_sample_log(path: str):
     Write a small synthetic scheduler log for testing.
 
     The block includes PIDs 1–4, where only PIDs 3 and 4 are relevant to the
-    agent (RUNNABLE and pid > 2).
+    agent (RUNNABLE and pid > 2), plus a kernel thread (pid -1) reported
+    with the newer 7-field PROC format.
     """
     sample_log = """SCHED_LOG_START
 TIMESTAMP:100
+POLICY:advised,1
+PREEMPT:2,5
+STARVE:95,3,31,4
+STARVE:97,4,30,0
 PROC:1,3,50,10,5,30
 PROC:2,3,25,15,8,12
 PROC:3,3,5,20,12,2
-PROC:4,3,8,30,20,5
+PROC:4,3,8,30,20,5,0,2,7,1,12,2,-5,3,40,0,4,25
+PROC:-1,3,1,0,0,1,1
+GROUP:0,100,3,80,45
+GROUP:1,200,1,8,30
+GANG:4,2,-1
 SCHED_LOG_END
 """
     with open(path, "w", encoding="utf-8") as f:
@@ -71,6 +80,48 @@ def test_log_parsing(agent: LLMSchedulerAgent) -> bool:
             print(f"[x] Unexpected timestamp {ts}, expected 100.")
             return False
 
+        kthreads = [p.pid for p in processes if p.is_kthread]
+        if kthreads != [-1]:
+            print(f"[x] Expected kernel thread pid -1 from the flags field, got {kthreads}.")
+            return False
+
+        p4 = [p for p in processes if p.pid == 4]
+        if not p4 or p4[0].last_cpu != 2 or p4[0].migrations != 7:
+            print("[x] Expected PID 4 to report LASTCPU=2 MIGRATIONS=7.")
+            return False
+
+        if p4[0].lock_wait != 12 or p4[0].inversions != 2:
+            print("[x] Expected PID 4 to report LOCKWAIT=12 with 2 inversions.")
+            return False
+
+        if p4[0].nice != -5:
+            print("[x] Expected PID 4 to report NICE=-5.")
+            return False
+
+        if p4[0].group != 1 or sorted(agent.groups) != [0, 1] or agent.groups[1].share != 200:
+            print("[x] Expected PID 4 in group 1 and GROUP lines for groups 0 and 1.")
+            return False
+
+        if agent.policy != "advised":
+            print("[x] Expected the kernel policy to be 'advised'.")
+            return False
+
+        if p4[0].vcsw != 3 or p4[0].ivcsw != 40 or agent._slice_for(p4[0]) != 4:
+            print("[x] Expected CPU-bound PID 4 (VCSW=3 IVCSW=40) to be given a long slice.")
+            return False
+
+        sibling = ProcessStats(pid=5, state=3, cpu_ticks=0, wait_ticks=0, io_count=0,
+                               recent_cpu=0, gang=4)
+        if (p4[0].gang != 4 or agent.gangs[4].nmembers != 2
+                or agent._gang_for(p4[0], [p4[0], sibling]) != 4
+                or agent._gang_for(p4[0], [p4[0]]) is not None):
+            print("[x] Expected PID 4 in gang 4, advised as a gang only with a runnable sibling.")
+            return False
+
+        if p4[0].max_wait != 25 or agent.starvations != 2 or agent.starved_despite_advice != 1:
+            print("[x] Expected MAXWAIT=25 and two STARVE events, one overriding advice.")
+            return False
+
         print(f"[✓] Parsed TS={ts} with {len(processes)} processes:")
         for p in processes:
             print(
@@ -89,12 +140,14 @@ def test_prompt(agent: LLMSchedulerAgent) -> bool:
     Ensures:
       - Only RUNNABLE processes with pid > 2 appear in the prompt.
       - The expected PIDs {3, 4} are present, and PID 2 is excluded.
+      - Kernel threads are never offered, even when RUNNABLE.
     """
     print("==== Test: Prompt Generation ====")
     sample_data = [
         ProcessStats(pid=3, state=3, cpu_ticks=5,  wait_ticks=20, io_count=12, recent_cpu=2),   # RUNNABLE
         ProcessStats(pid=4, state=3, cpu_ticks=8,  wait_ticks=30, io_count=20, recent_cpu=5),   # RUNNABLE
         ProcessStats(pid=2, state=2, cpu_ticks=25, wait_ticks=15, io_count=8,  recent_cpu=12),  # NOT RUNNABLE
+        ProcessStats(pid=9, state=3, cpu_ticks=1,  wait_ticks=90, io_count=0,  recent_cpu=0, flags=1),  # KTHREAD
     ]
     prompt = agent.format_prompt_for_llm(sample_data)  # public API
     if not prompt:
@@ -107,11 +160,12 @@ def test_prompt(agent: LLMSchedulerAgent) -> bool:
 
     # Only RUNNABLE (state==3) and pid>2 should appear → {3,4}
     pids_in_prompt = _extract_pids_from_prompt(prompt)
-    ok = (3 in pids_in_prompt) and (4 in pids_in_prompt) and (2 not in pids_in_prompt)
+    ok = (3 in pids_in_prompt) and (4 in pids_in_prompt) and (2 not in pids_in_prompt) \
+        and (9 not in pids_in_prompt)
     if not ok:
         print(
             f"[x] Unexpected PIDs in prompt. "
-            f"Found: {sorted(pids_in_prompt)}; expected to include 3,4 and exclude 2."
+            f"Found: {sorted(pids_in_prompt)}; expected to include 3,4 and exclude 2,9."
         )
     else:
         print("[✓] Prompt includes only RUNNABLE PIDs and expected fields.\n")
@@ -8,6 +8,7 @@ struct spinlock;
 struct sleeplock;
 struct stat;
 struct superblock;
+struct sysstat;
 
 // bio.c
 void            binit(void);
@@ -29,8 +30,10 @@ int             kexec(char*, char**);
 struct file*    filealloc(void);
 void            fileclose(struct file*);
 struct file*    filedup(struct file*);
+struct file*    fileget(int fd);
 void            fileinit(void);
 int             fileread(struct file*, uint64, int n);
+int             fileseek(struct file*, int off, int whence);
 int             filestat(struct file*, uint64 addr);
 int             filewrite(struct file*, uint64, int n);
 
@@ -67,7 +70,7 @@ void            begin_op(void);
 void            end_op(void);
 
 // pipe.c
-int             pipealloc(struct file**, struct file**);
+int             pipealloc(struct file**, struct file**, int);
 void            pipeclose(struct pipe*, int);
 int             piperead(struct pipe*, uint64, int);
 int             pipewrite(struct pipe*, uint64, int);
@@ -81,7 +84,23 @@ void            printfinit(void);
 int             cpuid(void);
 void            kexit(int);
 int             kfork(void);
-int             growproc(int);
+uint64          growproc(int, int);
+int             kclone(uint64, uint64, uint64, uint64);
+int             kfutex(uint64, int, int);
+int             reapthreads(struct proc*, int);
+int             setaffinity(int, int);
+int             setrealtime(int, int, int, int);
+int             setschedgroup(int, int, int);
+int             pi_wait(int, int);
+void            pi_release(int);
+int             getpriority(int, uint64);
+int             setpriority(int, int);
+int             schedtick(struct proc*);
+int             setschedpolicy(int);
+int             settimeslice(int, int);
+int             setgang(int, int);
+int             setstarvebound(int);
+struct proc*    tgleader(struct proc*);
 void            proc_mapstacks(pagetable_t);
 pagetable_t     proc_pagetable(struct proc *);
 void            proc_freepagetable(pagetable_t, uint64);
@@ -94,10 +113,13 @@ void            procinit(void);
 void            scheduler(void) __attribute__((noreturn));
 void            sched(void);
 void            sleep(void*, struct spinlock*);
+int             kpause(int);
+int             kthread_create(char*, void (*)(void));
 void            userinit(void);
 int             kwait(uint64);
 void            wakeup(void*);
 void            yield(void);
+void            yield_preempted(void);
 int             either_copyout(int user_dst, uint64 dst, void *src, uint64 len);
 int             either_copyin(void *dst, int user_src, uint64 src, uint64 len);
 void            procdump(void);
@@ -107,6 +129,10 @@ void            procdump(void);
 // and to emit SCHED_LOG_* snapshots for the external agent.
 void            update_sched_stats(void);
 void            log_scheduling_state(void);
+int             set_llm_advice(int);
+void            schedloginit(void);
+void            schedlog_request(void);
+int             procsysstat(int, uint64);
 
 // swtch.S
 void            swtch(struct context*, struct context*);
@@ -141,6 +167,7 @@ void            argaddr(int, uint64 *);
 int             fetchstr(uint64, char*, int);
 int             fetchaddr(uint64, uint64*);
 void            syscall(void);
+extern struct sysstat sysstat_total;
 
 // trap.c
 extern uint     ticks;
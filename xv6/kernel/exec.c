@@ -3,6 +3,7 @@
 #include "memlayout.h"
 #include "riscv.h"
 #include "spinlock.h"
+#include "sysstat.h"
 #include "proc.h"
 #include "defs.h"
 #include "elf.h"
@@ -35,6 +36,10 @@ kexec(char *path, char **argv)
   pagetable_t pagetable = 0, oldpagetable;
   struct proc *p = myproc();
 
+  // Other threads would lose the page table they're running on.
+  if(p->leader || reapthreads(p, 0) > 0)
+    return -1;
+
   begin_op();
 
   // Open the executable file.
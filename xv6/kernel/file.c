@@ -11,6 +11,8 @@
 #include "sleeplock.h"
 #include "file.h"
 #include "stat.h"
+#include "fcntl.h"
+#include "sysstat.h"
 #include "proc.h"
 
 struct devsw devsw[NDEV];
@@ -55,6 +57,26 @@ filedup(struct file *f)
   return f;
 }
 
+// Look up fd in the current process's file table and return
+// its file with a reference taken, or 0. Threads share the
+// table, so without the reference a sibling's close() could
+// free the file while we are still in fileread() or the like.
+// The caller drops it with fileclose().
+struct file*
+fileget(int fd)
+{
+  struct proc *l = tgleader(myproc());
+  struct file *f;
+
+  if(fd < 0 || fd >= NOFILE)
+    return 0;
+  acquire(&l->tglock);
+  if((f = l->ofile[fd]) != 0)
+    filedup(f);
+  release(&l->tglock);
+  return f;
+}
+
 // Close file f.  (Decrement ref count, close when reaches 0.)
 void
 fileclose(struct file *f)
@@ -101,6 +123,35 @@ filestat(struct file *f, uint64 addr)
   return -1;
 }
 
+// Move file f's offset to off bytes from whence (SEEK_SET,
+// SEEK_CUR or SEEK_END). Only inodes can seek, and not past
+// the end of the file, since writei() can't leave holes.
+// Returns the new offset, or -1.
+int
+fileseek(struct file *f, int off, int whence)
+{
+  long base;
+
+  if(f->type != FD_INODE)
+    return -1;
+  ilock(f->ip);
+  if(whence == SEEK_SET)
+    base = 0;
+  else if(whence == SEEK_CUR)
+    base = f->off;
+  else if(whence == SEEK_END)
+    base = f->ip->size;
+  else
+    base = -1;
+  if(base < 0 || base + off < 0 || base + off > f->ip->size){
+    iunlock(f->ip);
+    return -1;
+  }
+  f->off = base + off;
+  iunlock(f->ip);
+  return f->off;
+}
+
 // Read from file f.
 // addr is a user virtual address.
 int
@@ -0,0 +1,3 @@
+// Operations understood by futex(addr, op, val).
+#define FUTEX_WAIT  0   // sleep while *addr == val
+#define FUTEX_WAKE  1   // wake up to val threads sleeping on addr
@@ -6,6 +6,7 @@
 #include "sleeplock.h"
 #include "fs.h"
 #include "buf.h"
+#include "sysstat.h"
 
 // Simple logging that allows concurrent FS system calls.
 //
@@ -198,8 +199,10 @@ commit()
     write_log();     // Write modified blocks from cache to log
     write_head();    // Write header to disk -- the real commit
     install_trans(0); // Now install writes to home locations
+    __sync_fetch_and_add(&sysstat_total.logblocks, log.lh.n);
     log.lh.n = 0;
     write_head();    // Erase the transaction from the log
+    __sync_fetch_and_add(&sysstat_total.logcommits, 1);
   }
 }
 
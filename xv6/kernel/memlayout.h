@@ -17,6 +17,11 @@
 // end -- start of kernel page allocation area
 // PHYSTOP -- end RAM used by the kernel
 
+// core local interruptor (CLINT); writing 1 to a hart's MSIP
+// register sends it a machine-mode software interrupt (an IPI).
+#define CLINT 0x2000000L
+#define CLINT_MSIP(hart) (CLINT + 4*(hart))
+
 // qemu puts UART registers here in physical memory.
 #define UART0 0x10000000L
 #define UART0_IRQ 10
@@ -54,6 +59,25 @@
 //   fixed-size stack
 //   expandable heap
 //   ...
+//   USERTOP
+//   thread trapframes (one page per clone()d thread)
+//   URING (submission/completion ring, if set up)
+//   USYSCALL (read-only page shared with the kernel)
 //   TRAPFRAME (p->trapframe, used by the trampoline)
 //   TRAMPOLINE (the same page as in the kernel)
 #define TRAPFRAME (TRAMPOLINE - PGSIZE)
+#define USYSCALL (TRAPFRAME - PGSIZE)
+#define URING (USYSCALL - PGSIZE)
+#define THREADTF(i) (URING - ((i)+1)*PGSIZE)
+#define USERTOP (URING - NTHREAD*PGSIZE)
+
+#ifndef __ASSEMBLER__
+// Contents of the USYSCALL page. The kernel fills it in and
+// user code reads it directly (see ulib.c), so getpid() and
+// uptime() don't need to trap into the kernel.
+struct usyscall {
+  int pid;          // Process ID
+  uint ticks;       // Copy of the kernel's ticks, updated by clockintr()
+  int cpu;          // CPU the main thread was last dispatched on
+};
+#endif
@@ -1,5 +1,9 @@
 #define NPROC        64  // maximum number of processes
 #define NCPU          8  // maximum number of CPUs
+#define NTHREAD       8  // maximum clone()d threads per process
+#define NSGROUP       8  // scheduling groups (fair-share, see proc.c)
+#define NGANG         8  // co-scheduled gangs in use at once (see setgang())
+#define NSTARVE      16  // starvation events kept between SCHED_LOGs
 #define NOFILE       16  // open files per process
 #define NFILE       100  // open files per system
 #define NINODE       50  // maximum number of active i-nodes
@@ -3,10 +3,12 @@
 #include "defs.h"
 #include "param.h"
 #include "spinlock.h"
+#include "sysstat.h"
 #include "proc.h"
 #include "fs.h"
 #include "sleeplock.h"
 #include "file.h"
+#include "fcntl.h"
 
 #define PIPESIZE 512
 
@@ -17,10 +19,12 @@ struct pipe {
   uint nwrite;    // number of bytes written
   int readopen;   // read fd is still open
   int writeopen;  // write fd is still open
+  int lines;      // O_LINES: a read stops after a newline
 };
 
+// flags is 0 or O_LINES.
 int
-pipealloc(struct file **f0, struct file **f1)
+pipealloc(struct file **f0, struct file **f1, int flags)
 {
   struct pipe *pi;
 
@@ -34,6 +38,7 @@ pipealloc(struct file **f0, struct file **f1)
   pi->writeopen = 1;
   pi->nwrite = 0;
   pi->nread = 0;
+  pi->lines = (flags & O_LINES) != 0;
   initlock(&pi->lock, "pipe");
   (*f0)->type = FD_PIPE;
   (*f0)->readable = 1;
@@ -127,6 +132,10 @@ piperead(struct pipe *pi, uint64 addr, int n)
       break;
     }
     pi->nread++;
+    if(pi->lines && ch == '\n'){
+      i++;
+      break;
+    }
   }
   wakeup(&pi->nwrite);  //DOC: piperead-wakeup
   release(&pi->lock);
@@ -3,18 +3,30 @@
 #include "memlayout.h"
 #include "riscv.h"
 #include "spinlock.h"
+#include "sysstat.h"
 #include "proc.h"
 #include "defs.h"
+#include "futex.h"
+#include "schedpolicy.h"
 
 struct cpu cpus[NCPU];
 struct proc proc[NPROC];
 struct proc *initproc;
 
 int nextpid = 1;
+int nextkpid = -1;             // kernel threads count down from -1
 struct spinlock pid_lock;
 
 extern void forkret(void);
+static void kthreadret(void);
 static void freeproc(struct proc *p);
+static void setrunnable(struct proc *p);
+static void dequeue(struct proc *p);
+static struct schedpolicy *policy(void);
+static int gangjoin(int id);
+static int effprio(struct proc *p);
+static void preempt(struct proc *p);
+static void gangleave(int id);
 
 extern char trampoline[]; // trampoline.S
 
@@ -24,10 +36,32 @@ extern char trampoline[]; // trampoline.S
 // must be acquired before any p->lock.
 struct spinlock wait_lock;
 
+// serializes futex value checks against wakeups; see kfutex().
+struct spinlock futex_lock;
+
+// CPUs that have entered scheduler(), so setaffinity() can
+// refuse a mask that nothing would ever run.
+static int cpus_online;
+
+// Kicks sent by preempt() to make a CPU run a woken process:
+// those that interrupted a less important running process, and
+// those that only woke an idle CPU.
+static int npreempts, nidlekicks;
+
+// The starvation guard: a process RUNNABLE for starve_bound
+// ticks (0 = never) runs next, whatever the policy or advice
+// says. The last NSTARVE times it stepped in are kept for
+// SCHED_LOG, which reports those since starve_logged.
+// Protected by starve_lock.
+static int starve_bound = STARVE_DEFAULT;
+static struct starve starvelog[NSTARVE];
+static int nstarve, starve_logged;
+struct spinlock starve_lock;
+
 // LLM advice state used by the scheduler. Advice is injected
 // from user space via the set_llm_advice() syscall.
 struct spinlock llm_lock;
-int  llm_recommended_pid  = -1;
+int  llm_recommended_pid  = -1;  // or -gang; see set_llm_advice()
 int  llm_advice_valid     = 0;
 uint llm_advice_timestamp = 0;
 
@@ -35,6 +69,34 @@ uint llm_advice_timestamp = 0;
 // from following stale decisions.
 #define ADVICE_TIMEOUT_TICKS 200
 
+// Admission control for the real-time class: the reservations'
+// summed runtime/period, in thousandths of one CPU, may not
+// exceed this, so the rest of the system can't be starved.
+#define RT_UTIL_MAX 900
+
+// serializes policy switches; see setschedpolicy().
+struct spinlock policy_lock;
+
+// serializes real-time admission tests; see setrealtime().
+struct spinlock rt_lock;
+
+// Scheduling groups for two-level fair share. A group's vruntime
+// grows by SG_SCALE/share per tick its processes run, and
+// round-robin serves the group with the least vruntime first.
+// Protected by sg_lock; acquire after any p->lock.
+struct schedgroup sgroups[NSGROUP];
+struct spinlock sg_lock;
+#define SG_SCALE 1000000
+
+// Gangs, and the one whose slot is open: while ticks is before
+// gang_until, harts run its RUNNABLE members ahead of whatever
+// the policy would pick. Protected by gang_lock; acquire after
+// any p->lock.
+struct gang gangs[NGANG];
+static int gang_slot;
+static uint gang_until;
+struct spinlock gang_lock;
+
 // Allocate a page for each process's kernel stack.
 // Map it high in memory, followed by an invalid
 // guard page.
@@ -61,9 +123,18 @@ procinit(void)
   initlock(&pid_lock, "nextpid");
   initlock(&wait_lock, "wait_lock");
   initlock(&llm_lock, "llm_advice");
+  initlock(&policy_lock, "policy");
+  initlock(&futex_lock, "futex");
+  initlock(&rt_lock, "rt_admit");
+  initlock(&sg_lock, "sgroups");
+  initlock(&gang_lock, "gangs");
+  initlock(&starve_lock, "starve");
+  for(int g = 0; g < NSGROUP; g++)
+    sgroups[g].share = SG_DEFAULT_SHARE;
 
   for(p = proc; p < &proc[NPROC]; p++) {
     initlock(&p->lock, "proc");
+    initlock(&p->tglock, "tglock");
     p->state = UNUSED;
     p->kstack = KSTACK((int) (p - proc));
     p->cpu_ticks  = 0;
@@ -117,12 +188,28 @@ allocpid(void)
   return pid;
 }
 
+// Kernel threads get negative pids, so user pids keep their
+// usual boot-time values (init=1, its router=2, llmhelper=3)
+// and set_llm_advice() can never name a kernel thread.
+static int
+allockpid(void)
+{
+  int pid;
+
+  acquire(&pid_lock);
+  pid = nextkpid;
+  nextkpid = nextkpid - 1;
+  release(&pid_lock);
+
+  return pid;
+}
+
 // Look in the process table for an UNUSED proc.
 // If found, initialize state required to run in the kernel,
 // and return with p->lock held.
-// If there are no free procs, or a memory allocation fails, return 0.
+// If there are no free procs, return 0.
 static struct proc*
-allocproc(void)
+allocslot(void)
 {
   struct proc *p;
 
@@ -137,7 +224,6 @@ allocproc(void)
   return 0;
 
 found:
-  p->pid = allocpid();
   p->state = USED;
 
   // Reset scheduler statistics for a fresh process.
@@ -145,7 +231,46 @@ found:
   p->wait_ticks = 0;
   p->io_count   = 0;
   p->recent_cpu = 0;
+  memset(&p->sysstat, 0, sizeof(p->sysstat));
   p->sz = 0;
+  p->affinity = AFFINITY_ALL;
+  p->lastcpu = -1;
+  p->migrations = 0;
+  p->rt = 0;
+  p->sgid = 0;
+  p->advised = 0;
+  p->nice = 0;
+  p->skip = 0;
+  memset(p->pi_boost, 0, sizeof(p->pi_boost));
+  p->lockwait_ticks = 0;
+  p->inversions = 0;
+  p->curwait = 0;
+  p->maxwait = 0;
+  p->timeslice = 0;
+  p->gang = 0;
+  p->nvcsw = 0;
+  p->nivcsw = 0;
+
+  // Set up new context to start executing at forkret,
+  // which returns to user space.
+  memset(&p->context, 0, sizeof(p->context));
+  p->context.ra = (uint64)forkret;
+  p->context.sp = p->kstack + PGSIZE;
+
+  return p;
+}
+
+// Allocate a user process: a proc slot plus its trapframe,
+// usyscall page and user page table.
+// Returns with p->lock held, or 0 if out of procs or memory.
+static struct proc*
+allocproc(void)
+{
+  struct proc *p;
+
+  if((p = allocslot()) == 0)
+    return 0;
+  p->pid = allocpid();
 
   // Allocate a trapframe page.
   if((p->trapframe = (struct trapframe *)kalloc()) == 0){
@@ -153,6 +278,17 @@ found:
     release(&p->lock);
     return 0;
   }
+  p->tfva = TRAPFRAME;
+
+  // Allocate the page user space reads pid and ticks from.
+  if((p->usyscall = (struct usyscall *)kalloc()) == 0){
+    freeproc(p);
+    release(&p->lock);
+    return 0;
+  }
+  memset(p->usyscall, 0, PGSIZE);
+  p->usyscall->pid = p->pid;
+  p->usyscall->ticks = ticks;
 
   // An empty user page table.
   p->pagetable = proc_pagetable(p);
@@ -162,24 +298,60 @@ found:
     return 0;
   }
 
-  // Set up new context to start executing at forkret,
-  // which returns to user space.
-  memset(&p->context, 0, sizeof(p->context));
-  p->context.ra = (uint64)forkret;
-  p->context.sp = p->kstack + PGSIZE;
-
   return p;
 }
 
+// Start a kernel thread that runs fn() forever on its own
+// kernel stack. It has no user memory, trapframe or page
+// table, and is dispatched ahead of user processes by
+// scheduler(), so fn should do short bursts of deferred
+// work and then sleep(). Returns the thread's pid, or -1.
+int
+kthread_create(char *name, void (*fn)(void))
+{
+  struct proc *p;
+  int pid;
+
+  if((p = allocslot()) == 0)
+    return -1;
+  p->pid = allockpid();
+  p->kthread = 1;
+  p->kfn = fn;
+  p->context.ra = (uint64)kthreadret;
+  safestrcpy(p->name, name, sizeof(p->name));
+  pid = p->pid;
+  setrunnable(p);
+  release(&p->lock);
+
+  return pid;
+}
+
 // free a proc structure and the data hanging from it,
 // including user pages.
 // p->lock must be held.
 static void
 freeproc(struct proc *p)
 {
+  if(p->leader){
+    // a thread's page table is its leader's; just take the
+    // thread's trapframe back out of it.
+    if(p->pagetable){
+      acquire(&p->leader->tglock);
+      uvmunmap(p->pagetable, p->tfva, 1, 0);
+      release(&p->leader->tglock);
+    }
+    p->pagetable = 0;
+  }
   if(p->trapframe)
     kfree((void*)p->trapframe);
   p->trapframe = 0;
+  p->tfva = 0;
+  if(p->usyscall)
+    kfree((void*)p->usyscall);
+  p->usyscall = 0;
+  if(p->uring)
+    kfree((void*)p->uring);
+  p->uring = 0;
   if(p->pagetable)
     proc_freepagetable(p->pagetable, p->sz);
   p->pagetable = 0;
@@ -190,6 +362,10 @@ freeproc(struct proc *p)
   p->chan = 0;
   p->killed = 0;
   p->xstate = 0;
+  p->kthread = 0;
+  p->kfn = 0;
+  p->leader = 0;
+  p->ctid = 0;
 
   // Reset scheduler statistics for this slot.
   p->cpu_ticks  = 0;
@@ -201,7 +377,8 @@ freeproc(struct proc *p)
 }
 
 // Create a user page table for a given process, with no user memory,
-// but with trampoline and trapframe pages.
+// but with trampoline, trapframe and usyscall pages, plus the
+// process's uring page if it has set one up.
 pagetable_t
 proc_pagetable(struct proc *p)
 {
@@ -231,6 +408,27 @@ proc_pagetable(struct proc *p)
     return 0;
   }
 
+  // map the usyscall page just below the trapframe page.
+  // user-readable but not writable, so a process can't
+  // forge its own pid or clock.
+  if(mappages(pagetable, USYSCALL, PGSIZE,
+              (uint64)(p->usyscall), PTE_R | PTE_U) < 0){
+    uvmunmap(pagetable, TRAPFRAME, 1, 0);
+    uvmunmap(pagetable, TRAMPOLINE, 1, 0);
+    uvmfree(pagetable, 0);
+    return 0;
+  }
+
+  // keep the ring mapped across exec.
+  if(p->uring && mappages(pagetable, URING, PGSIZE,
+                          (uint64)(p->uring), PTE_R | PTE_W | PTE_U) < 0){
+    uvmunmap(pagetable, USYSCALL, 1, 0);
+    uvmunmap(pagetable, TRAPFRAME, 1, 0);
+    uvmunmap(pagetable, TRAMPOLINE, 1, 0);
+    uvmfree(pagetable, 0);
+    return 0;
+  }
+
   return pagetable;
 }
 
@@ -241,6 +439,8 @@ proc_freepagetable(pagetable_t pagetable, uint64 sz)
 {
   uvmunmap(pagetable, TRAMPOLINE, 1, 0);
   uvmunmap(pagetable, TRAPFRAME, 1, 0);
+  uvmunmap(pagetable, USYSCALL, 1, 0);
+  uvmunmap(pagetable, URING, 1, 0);
   uvmfree(pagetable, sz);
 }
 
@@ -259,34 +459,56 @@ userinit(void)
   p->cwd = namei("/");
 
   // Mark runnable; forkret() will run fsinit + kexec("/init").
-  p->state = RUNNABLE;
+  setrunnable(p);
 
   // Done with p->lock from allocproc().
   release(&p->lock);
 }
 
-// Grow or shrink user memory by n bytes.
-// Return 0 on success, -1 on failure.
-int
-growproc(int n)
+// Grow or shrink user memory by n bytes. If lazy is set, growth
+// only raises the size and vmfault() allocates pages on first use.
+// Threads share the page table, so the new size is made under the
+// leader's tglock and given to the whole thread group.
+// Return the old size, or -1 on failure.
+uint64
+growproc(int n, int lazy)
 {
-  uint64 sz;
+  uint64 oldsz, sz;
   struct proc *p = myproc();
+  struct proc *l = tgleader(p);
+  struct proc *pp;
 
-  sz = p->sz;
+  acquire(&l->tglock);
+  oldsz = sz = p->sz;
   if(n > 0){
-    // Avoid growing into the trapframe mapping.
-    if(sz + n > TRAPFRAME) {
-      return -1;
-    }
-    if((sz = uvmalloc(p->pagetable, sz, sz + n, PTE_W)) == 0) {
-      return -1;
-    }
+    // Avoid growing into the thread trapframe, uring, usyscall
+    // and trapframe mappings.
+    if(sz + n < sz || sz + n > USERTOP)
+      goto bad;
+    if(lazy)
+      sz += n;
+    else if((sz = uvmalloc(p->pagetable, sz, sz + n, PTE_W)) == 0)
+      goto bad;
   } else if(n < 0){
     sz = uvmdealloc(p->pagetable, sz, sz + n);
   }
-  p->sz = sz;
-  return 0;
+  for(pp = proc; pp < &proc[NPROC]; pp++)
+    if(pp == l || pp->leader == l)
+      pp->sz = sz;
+  release(&l->tglock);
+  return oldsz;
+
+bad:
+  release(&l->tglock);
+  return -1;
+}
+
+// The process whose page table, size and open files p uses:
+// p itself, or the leader of p's thread group.
+struct proc*
+tgleader(struct proc *p)
+{
+  return p->leader ? p->leader : p;
 }
 
 // Create a new process, copying the parent.
@@ -303,13 +525,21 @@ kfork(void)
     return -1;
   }
 
-  // Copy user memory from parent to child.
+  // Copy user memory from parent to child, and increment
+  // reference counts on open file descriptors, keeping other
+  // threads from changing either meanwhile.
+  acquire(&tgleader(p)->tglock);
   if(uvmcopy(p->pagetable, np->pagetable, p->sz) < 0){
+    release(&tgleader(p)->tglock);
     freeproc(np);
     release(&np->lock);
     return -1;
   }
   np->sz = p->sz;
+  for(i = 0; i < NOFILE; i++)
+    if(tgleader(p)->ofile[i])
+      np->ofile[i] = filedup(tgleader(p)->ofile[i]);
+  release(&tgleader(p)->tglock);
 
   // copy saved user registers.
   *(np->trapframe) = *(p->trapframe);
@@ -317,11 +547,13 @@ kfork(void)
   // Cause fork to return 0 in the child.
   np->trapframe->a0 = 0;
 
-  // increment reference counts on open file descriptors.
-  for(i = 0; i < NOFILE; i++)
-    if(p->ofile[i])
-      np->ofile[i] = filedup(p->ofile[i]);
   np->cwd = idup(p->cwd);
+  np->affinity = p->affinity;
+  np->sgid = p->sgid;
+  np->nice = p->nice;
+  np->timeslice = p->timeslice;
+  if((np->gang = p->gang) != 0)
+    gangjoin(np->gang);
 
   safestrcpy(np->name, p->name, sizeof(p->name));
 
@@ -334,7 +566,7 @@ kfork(void)
   release(&wait_lock);
 
   acquire(&np->lock);
-  np->state = RUNNABLE;
+  setrunnable(np);
   release(&np->lock);
 
   return pid;
@@ -366,13 +598,24 @@ kexit(int status)
   if(p == initproc)
     panic("init exiting");
 
-  // Close all open files.
-  for(int fd = 0; fd < NOFILE; fd++){
-    if(p->ofile[fd]){
-      struct file *f = p->ofile[fd];
-      fileclose(f);
-      p->ofile[fd] = 0;
+  if(p->leader == 0){
+    // Our threads run on our page table and files, so they
+    // go first.
+    reapthreads(p, 1);
+
+    // Close all open files.
+    for(int fd = 0; fd < NOFILE; fd++){
+      if(p->ofile[fd]){
+        struct file *f = p->ofile[fd];
+        fileclose(f);
+        p->ofile[fd] = 0;
+      }
     }
+  } else if(p->ctid){
+    // Tell thread_join() we're done.
+    int zero = 0;
+    if(copyout(p->pagetable, p->ctid, (char *)&zero, sizeof(zero)) == 0)
+      kfutex(p->ctid, FUTEX_WAKE, NPROC);
   }
 
   begin_op();
@@ -380,6 +623,9 @@ kexit(int status)
   end_op();
   p->cwd = 0;
 
+  if(p->gang)
+    gangleave(p->gang);
+
   acquire(&wait_lock);
 
   // Give any children to init.
@@ -415,7 +661,8 @@ kwait(uint64 addr)
     // Scan through table looking for exited children.
     havekids = 0;
     for(pp = proc; pp < &proc[NPROC]; pp++){
-      if(pp->parent == p){
+      // threads are reaped by reapthreads(), not wait().
+      if(pp->parent == p && pp->leader == 0){
         // make sure the child isn't still in exit() or swtch().
         acquire(&pp->lock);
 
@@ -449,204 +696,1271 @@ kwait(uint64 addr)
   }
 }
 
-// Per-CPU process scheduler.
-// Each CPU calls scheduler() after setting itself up.
-// Scheduler never returns.  It loops, doing:
-//  - choose a process to run (using LLM advice when available);
-//  - swtch to start running that process;
-//  - eventually that process transfers control
-//    via swtch back to the scheduler.
-void
-scheduler(void)
+// Create a thread that starts at fn(arg) on the user stack
+// ending at stack. It shares the caller's page table and open
+// file table; its registers, kernel stack and trapframe are
+// its own. If ctid is non-zero the thread's pid is stored
+// there, and cleared with a FUTEX_WAKE when the thread exits.
+// Returns the new thread's pid, or -1.
+int
+kclone(uint64 fn, uint64 arg, uint64 stack, uint64 ctid)
 {
-  struct proc *p;
-  struct cpu *c = mycpu();
+  int i, pid;
+  struct proc *np;
+  struct proc *p = myproc();
+  struct proc *l = tgleader(p);
 
-  c->proc = 0;
-  for(;;){
-    // The most recent process to run may have had interrupts
-    // turned off; enable them to avoid a deadlock if all
-    // processes are waiting. Then turn them back off
-    // to avoid a possible race between an interrupt
-    // and wfi.
-    intr_on();
-    intr_off();
+  pid = allocpid();
+  if(ctid && copyout(p->pagetable, ctid, (char *)&pid, sizeof(pid)) < 0)
+    return -1;
 
-    int found = 0;
+  // Exited threads hold on to their trapframe slots.
+  reapthreads(l, 0);
 
-    // Snapshot any current LLM advice under its own lock.
-    int advised_pid = -1;
-    int have_advice = 0;
-
-    acquire(&llm_lock);
-    if(llm_advice_valid &&
-       (ticks - llm_advice_timestamp) < ADVICE_TIMEOUT_TICKS){
-      advised_pid = llm_recommended_pid;
-      have_advice = 1;
-    }
-    release(&llm_lock);
-
-    // First try to honor LLM advice, if it refers to a RUNNABLE process.
-    if(have_advice){
-      for(p = proc; p < &proc[NPROC]; p++) {
-        acquire(&p->lock);
-        if(p->state == RUNNABLE && p->pid == advised_pid) {
-          p->state = RUNNING;
-          c->proc = p;
-
-          // Mark this advice as used so the agent can provide fresh input.
-          acquire(&llm_lock);
-          llm_advice_valid = 0;
-          release(&llm_lock);
-
-          swtch(&c->context, &p->context);
-
-          // Process is done running for now.
-          // It should have changed its p->state before coming back.
-          c->proc = 0;
-          found = 1;
-          release(&p->lock);
-          break;
-        }
-        release(&p->lock);
-      }
-    }
+  if((np = allocslot()) == 0)
+    return -1;
+  np->pid = pid;
+  if((np->trapframe = (struct trapframe *)kalloc()) == 0)
+    goto bad;
+
+  // Map the trapframe in the first free THREADTF() slot of
+  // the shared page table.
+  acquire(&l->tglock);
+  for(i = 0; i < NTHREAD; i++)
+    if(!ismapped(p->pagetable, THREADTF(i)))
+      break;
+  if(i == NTHREAD || mappages(p->pagetable, THREADTF(i), PGSIZE,
+                              (uint64)np->trapframe, PTE_R | PTE_W) < 0){
+    release(&l->tglock);
+    goto bad;
+  }
+  np->pagetable = p->pagetable;
+  np->tfva = THREADTF(i);
+  np->sz = p->sz;
+  np->leader = l;
+  release(&l->tglock);
 
-    // If no advised process ran, fall back to simple round-robin.
-    if(!found){
-      for(p = proc; p < &proc[NPROC]; p++) {
-        acquire(&p->lock);
-        if(p->state == RUNNABLE) {
-          p->state = RUNNING;
-          c->proc = p;
-          swtch(&c->context, &p->context);
+  // Start at fn(arg) on the new stack.
+  *(np->trapframe) = *(p->trapframe);
+  np->trapframe->epc = fn;
+  np->trapframe->a0 = arg;
+  np->trapframe->sp = stack;
+  np->ctid = ctid;
 
-          // Process is done running for now.
-          // It should have changed its p->state before coming back.
-          c->proc = 0;
-          found = 1;
-        }
-        release(&p->lock);
-      }
-    }
+  np->cwd = idup(p->cwd);
+  np->affinity = p->affinity;
+  np->sgid = p->sgid;
+  np->nice = p->nice;
+  np->timeslice = p->timeslice;
+  if((np->gang = p->gang) != 0)
+    gangjoin(np->gang);
+  safestrcpy(np->name, p->name, sizeof(p->name));
 
-    if(found == 0) {
-      // nothing to run; stop running on this core until an interrupt.
-      asm volatile("wfi");
-    }
-  }
-}
+  release(&np->lock);
 
-// Switch to scheduler.  Must hold only p->lock
-// and have changed proc->state. Saves and restores
-// intena because intena is a property of this
-// kernel thread, not this CPU. It should
-// be proc->intena and proc->noff, but that would
-// break in the few places where a lock is held but
-// there's no process.
-void
-sched(void)
-{
-  int intena;
-  struct proc *p = myproc();
+  acquire(&wait_lock);
+  np->parent = l;
+  release(&wait_lock);
 
-  if(!holding(&p->lock))
-    panic("sched p->lock");
-  if(mycpu()->noff != 1)
-    panic("sched locks");
-  if(p->state == RUNNING)
-    panic("sched RUNNING");
-  if(intr_get())
-    panic("sched interruptible");
+  acquire(&np->lock);
+  setrunnable(np);
+  release(&np->lock);
 
-  intena = mycpu()->intena;
-  swtch(&p->context, &mycpu()->context);
-  mycpu()->intena = intena;
+  return pid;
+
+bad:
+  freeproc(np);
+  release(&np->lock);
+  return -1;
 }
 
-// Give up the CPU for one scheduling round.
-void
-yield(void)
+// Free the exited threads of thread group leader p, and return
+// how many are still running. If kill is set, kill those and
+// wait for them to exit too.
+int
+reapthreads(struct proc *p, int kill)
 {
-  struct proc *p = myproc();
-  acquire(&p->lock);
-  p->state = RUNNABLE;
-  sched();
-  release(&p->lock);
+  struct proc *pp;
+  int n;
+
+  acquire(&wait_lock);
+  for(;;){
+    n = 0;
+    for(pp = proc; pp < &proc[NPROC]; pp++){
+      if(pp->leader != p)
+        continue;
+      acquire(&pp->lock);
+      if(pp->state == ZOMBIE){
+        freeproc(pp);
+      } else {
+        n++;
+        if(kill){
+          pp->killed = 1;
+          if(pp->state == SLEEPING)
+            setrunnable(pp);
+        }
+      }
+      release(&pp->lock);
+    }
+    if(n == 0 || !kill)
+      break;
+    // exiting threads wakeup() their parent, p.
+    sleep(p, &wait_lock);
+  }
+  release(&wait_lock);
+  return n;
 }
 
-// A fork child's very first scheduling by scheduler()
-// will swtch to forkret.
-void
-forkret(void)
+// Wait on or wake the user int at addr. Waiters sleep on its
+// physical address, which is the same for every thread sharing
+// the page table. FUTEX_WAIT sleeps only if *addr still equals
+// val, returning 0 once woken and -1 if it didn't sleep.
+// FUTEX_WAKE wakes up to val waiters and returns how many.
+int
+kfutex(uint64 addr, int op, int val)
 {
-  extern char userret[];
-  static int first = 1;
   struct proc *p = myproc();
+  struct proc *pp;
+  uint64 pa;
+  int v, n;
 
-  // Still holding p->lock from scheduler.
-  release(&p->lock);
+  if(addr % sizeof(int))
+    return -1;
 
-  if (first) {
-    // File system initialization must be run in the context of a
-    // regular process (e.g., because it calls sleep), and thus cannot
-    // be run from main().
-    fsinit(ROOTDEV);
+  acquire(&futex_lock);
+  if(copyin(p->pagetable, (char *)&v, addr, sizeof(v)) < 0 ||
+     (pa = walkaddr(p->pagetable, PGROUNDDOWN(addr))) == 0){
+    release(&futex_lock);
+    return -1;
+  }
+  pa += addr - PGROUNDDOWN(addr);
 
-    first = 0;
-    // make other cores see first=0.
-    __sync_synchronize();
+  if(op == FUTEX_WAIT){
+    if(v != val){
+      release(&futex_lock);
+      return -1;
+    }
+    sleep((void *)pa, &futex_lock);
+    release(&futex_lock);
+    return 0;
+  }
 
-    // We can invoke kexec() now that file system is initialized.
-    // Put the return value (argc) of kexec into a0.
-    p->trapframe->a0 = kexec("/init", (char *[]){ "/init", 0 });
-    if (p->trapframe->a0 == -1) {
-      panic("exec");
+  if(op == FUTEX_WAKE){
+    n = 0;
+    for(pp = proc; pp < &proc[NPROC] && n < val; pp++){
+      if(pp != p){
+        acquire(&pp->lock);
+        if(pp->state == SLEEPING && pp->chan == (void *)pa){
+          setrunnable(pp);
+          preempt(pp);
+          n++;
+        }
+        release(&pp->lock);
+      }
     }
+    release(&futex_lock);
+    return n;
   }
 
-  // return to user space, mimicing usertrap()'s return.
-  prepare_return();
-  uint64 satp = MAKE_SATP(p->pagetable);
-  uint64 trampoline_userret = TRAMPOLINE + (userret - trampoline);
-  ((void (*)(uint64))trampoline_userret)(satp);
+  release(&futex_lock);
+  return -1;
 }
 
-// Sleep on channel chan, releasing condition lock lk.
-// Re-acquires lk when awakened.
-void
-sleep(void *chan, struct spinlock *lk)
+// Find user process pid (the caller, if pid is 0) and return
+// it locked, or return 0.
+static struct proc*
+lockpid(int pid)
 {
-  struct proc *p = myproc();
-
-  // Must acquire p->lock in order to
-  // change p->state and then call sched.
-  // Once we hold p->lock, we can be
-  // guaranteed that we won't miss any wakeup
-  // (wakeup locks p->lock),
-  // so it's okay to release lk.
-
-  acquire(&p->lock);  //DOC: sleeplock1
-  release(lk);
-
-  // Go to sleep.
-  p->chan = chan;
-  p->state = SLEEPING;
-
-  sched();
-
-  // Tidy up.
-  p->chan = 0;
+  struct proc *p;
 
-  // Reacquire original lock.
-  release(&p->lock);
-  acquire(lk);
+  if(pid == 0)
+    pid = myproc()->pid;
+  for(p = proc; p < &proc[NPROC]; p++){
+    acquire(&p->lock);
+    if(p->pid == pid && p->state != UNUSED && !p->kthread)
+      return p;
+    release(&p->lock);
+  }
+  return 0;
 }
 
-// Wake up all processes sleeping on channel chan.
-// Caller should hold the condition lock.
-void
-wakeup(void *chan)
+// Restrict process pid (or the caller, if pid is 0) to the
+// CPUs in mask, inherited across fork() and clone(). Returns
+// the previous mask, or -1 if there's no such user process or
+// mask names no online CPU.
+int
+setaffinity(int pid, int mask)
+{
+  struct proc *p;
+  int old;
+
+  mask &= AFFINITY_ALL;
+  if((mask & __atomic_load_n(&cpus_online, __ATOMIC_RELAXED)) == 0)
+    return -1;
+  if((p = lockpid(pid)) == 0)
+    return -1;
+  old = p->affinity;
+  p->affinity = mask;
+  release(&p->lock);
+
+  // Move off this CPU at once if it's no longer allowed.
+  if(p == myproc()){
+    push_off();
+    int here = cpuid();
+    pop_off();
+    if((mask & (1 << here)) == 0)
+      yield();
+  }
+  return old;
+}
+
+// Put process pid (or the caller, if pid is 0) in the real-time
+// class with a reservation of runtime ticks every period ticks,
+// to be used within deadline ticks of each period's start.
+// runtime 0 takes it back out. The class isn't inherited by
+// fork(). Returns 0, or -1 if the parameters are inconsistent,
+// there's no such user process, or admitting it would push total
+// reserved utilization past RT_UTIL_MAX.
+int
+setrealtime(int pid, int runtime, int period, int deadline)
+{
+  struct proc *p, *target = 0;
+  uint64 util = 0;
+
+  if(runtime < 0 || (runtime > 0 && (deadline < runtime || period < deadline)))
+    return -1;
+  if(pid == 0)
+    pid = myproc()->pid;
+
+  acquire(&rt_lock);
+  for(p = proc; p < &proc[NPROC]; p++){
+    acquire(&p->lock);
+    if(p->pid == pid && p->state != UNUSED && !p->kthread)
+      target = p;
+    else if(p->rt)
+      util += (uint64)p->rt_runtime * 1000 / p->rt_period;
+    release(&p->lock);
+  }
+  if(target == 0 ||
+     (runtime > 0 && util + (uint64)runtime * 1000 / period > RT_UTIL_MAX)){
+    release(&rt_lock);
+    return -1;
+  }
+
+  acquire(&target->lock);
+  if(target->pid != pid){
+    // exited meanwhile.
+    release(&target->lock);
+    release(&rt_lock);
+    return -1;
+  }
+  target->rt = runtime > 0;
+  target->rt_runtime = runtime;
+  target->rt_period = period;
+  target->rt_deadline = deadline;
+  // the first period starts now.
+  target->rt_budget = runtime;
+  target->rt_dl = ticks + deadline;
+  target->rt_next = ticks + period;
+  release(&target->lock);
+  release(&rt_lock);
+  return 0;
+}
+
+// Move process pid (or the caller, if pid is 0) into scheduling
+// group gid, which its future children inherit, and if share is
+// positive, set the group's share. A negative pid sets only the
+// share. Returns 0, or -1 for a bad group, share or pid.
+int
+setschedgroup(int pid, int gid, int share)
+{
+  struct proc *p;
+
+  if(gid < 0 || gid >= NSGROUP || share > SG_MAX_SHARE)
+    return -1;
+
+  if(pid >= 0){
+    if((p = lockpid(pid)) == 0)
+      return -1;
+    p->sgid = gid;
+    release(&p->lock);
+  }
+
+  if(share > 0){
+    acquire(&sg_lock);
+    sgroups[gid].share = share;
+    release(&sg_lock);
+  }
+  return 0;
+}
+
+// Copy the nice value of process pid (0 = caller) to user
+// address addr. Returns 0, or -1 if there's no such process.
+int
+getpriority(int pid, uint64 addr)
+{
+  struct proc *p;
+  int nice;
+
+  if((p = lockpid(pid)) == 0)
+    return -1;
+  nice = p->nice;
+  release(&p->lock);
+  return copyout(myproc()->pagetable, addr, (char *)&nice, sizeof(nice));
+}
+
+// Set the nice value of process pid (0 = caller), clamped to
+// NICE_MIN..NICE_MAX. Returns 0, or -1 if there's no such process.
+int
+setpriority(int pid, int nice)
+{
+  struct proc *p;
+
+  if((p = lockpid(pid)) == 0)
+    return -1;
+  if(nice < NICE_MIN)
+    nice = NICE_MIN;
+  if(nice > NICE_MAX)
+    nice = NICE_MAX;
+  p->nice = nice;
+  p->skip = 0;
+  release(&p->lock);
+  return 0;
+}
+
+// Add a member to gang id, taking a free slot in gangs[] for it
+// if it's new. Returns 0, or -1 if gangs[] is full.
+static int
+gangjoin(int id)
+{
+  struct gang *g, *free = 0;
+
+  acquire(&gang_lock);
+  for(g = gangs; g < &gangs[NGANG]; g++){
+    if(g->id == id)
+      break;
+    if(g->nmembers == 0 && (free == 0 || (free->id != 0 && g->id == 0)))
+      free = g;
+  }
+  if(g == &gangs[NGANG]){
+    if((g = free) == 0){
+      release(&gang_lock);
+      return -1;
+    }
+    g->id = id;
+    g->ndone = 0;
+    g->skew = -1;
+  }
+  g->nmembers++;
+  release(&gang_lock);
+  return 0;
+}
+
+// A member is done with gang id (it exited or moved out); if
+// it's the last, record the round's skew.
+static void
+gangleave(int id)
+{
+  struct gang *g;
+
+  acquire(&gang_lock);
+  for(g = gangs; g < &gangs[NGANG]; g++){
+    if(g->id == id && g->nmembers > 0){
+      if(g->ndone++ == 0)
+        g->first_done = ticks;
+      if(--g->nmembers == 0){
+        g->skew = ticks - g->first_done;
+        g->ndone = 0;
+      }
+      break;
+    }
+  }
+  release(&gang_lock);
+}
+
+// Move process pid (or the caller, if pid is 0) into gang id,
+// or out of any gang if id is 0. Harts run a gang's members
+// together: once the policy picks one, the others run ahead of
+// the policy's choices on other harts for that one's quantum.
+// Returns the previous gang, or -1 if there's no such user
+// process, id is negative, or too many gangs are in use.
+int
+setgang(int pid, int id)
+{
+  struct proc *p;
+  int old;
+
+  if(id < 0)
+    return -1;
+  if((p = lockpid(pid)) == 0)
+    return -1;
+  old = p->gang;
+  if(id != old){
+    if(id && gangjoin(id) < 0){
+      release(&p->lock);
+      return -1;
+    }
+    if(old)
+      gangleave(old);
+    p->gang = id;
+  }
+  release(&p->lock);
+  return old;
+}
+
+// Timer ticks p runs before the timer makes it yield: its own
+// time slice, or the policy's if it has none, plus one for every
+// 3 points of negative nice.
+static int
+quantum(struct proc *p)
+{
+  int q = p->timeslice ? p->timeslice : policy()->slice;
+
+  return p->nice < 0 ? q + -p->nice / 3 : q;
+}
+
+// Set the time slice of process pid (0 = caller) to ticks, or
+// back to the policy's default if ticks is 0. pid -1 instead sets
+// the current policy's default, or with ticks 0 just reports it.
+// Returns the previous value, or -1 if there's no such user
+// process or ticks is out of range. Takes effect from the next
+// time the process is dispatched.
+int
+settimeslice(int pid, int ticks)
+{
+  struct schedpolicy *sp;
+  struct proc *p;
+  int old;
+
+  if(ticks < 0 || ticks > SLICE_MAX)
+    return -1;
+
+  if(pid == -1){
+    acquire(&policy_lock);
+    sp = policy();
+    old = sp->slice;
+    if(ticks > 0)
+      sp->slice = ticks;
+    release(&policy_lock);
+    return old;
+  }
+
+  if((p = lockpid(pid)) == 0)
+    return -1;
+  old = p->timeslice;
+  p->timeslice = ticks;
+  release(&p->lock);
+  return old;
+}
+
+// Round-robin turns p passes over after each one it takes:
+// one for every 4 points of positive nice.
+static int
+skips(struct proc *p)
+{
+  return p->nice > 0 ? p->nice / 4 : 0;
+}
+
+// May p run on CPU id?
+static int
+allowed(struct proc *p, int id)
+{
+  return (p->affinity & (1 << id)) != 0;
+}
+
+// Soft affinity: is CPU id where p should preferably run? That
+// is the CPU it last ran on, or any CPU if it hasn't run yet or
+// can no longer run there.
+static int
+home(struct proc *p, int id)
+{
+  return p->lastcpu < 0 || p->lastcpu == id || !allowed(p, p->lastcpu);
+}
+
+// Run p, which is RUNNABLE and locked, on this CPU until it
+// gives the CPU back.
+static void
+run(struct cpu *c, struct proc *p)
+{
+  int id = cpuid();
+
+  if(p->lastcpu >= 0 && p->lastcpu != id)
+    p->migrations++;
+  p->lastcpu = id;
+  if(p->usyscall)
+    p->usyscall->cpu = id;
+  p->curwait = 0;
+  p->slice = quantum(p);
+  dequeue(p);
+
+  p->state = RUNNING;
+  c->proc = p;
+  c->prio = p->kthread ? NPRIO : effprio(p);
+  swtch(&c->context, &p->context);
+
+  // Process is done running for now.
+  // It should have changed its p->state before coming back.
+  c->proc = 0;
+}
+
+// p's own priority for sleeplock priority inheritance.
+static int
+baseprio(struct proc *p)
+{
+  return p->rt ? PRIO_RT : p->advised ? PRIO_ADVISED : PRIO_NORMAL;
+}
+
+// p's effective priority: its own, or the highest lent to it by
+// waiters on sleeplocks it holds. Caller must hold p->lock.
+static int
+effprio(struct proc *p)
+{
+  int prio = baseprio(p);
+
+  for(int i = NPRIO - 1; i > prio; i--)
+    if(p->pi_boost[i])
+      return i;
+  return prio;
+}
+
+// Run each RUNNABLE process allowed on CPU id that has been lent
+// a priority above its own of at least prio. Returns whether any
+// ran.
+static int
+runboosted(struct cpu *c, int id, int prio)
+{
+  struct proc *p;
+  int found = 0, e;
+
+  for(p = proc; p < &proc[NPROC]; p++) {
+    acquire(&p->lock);
+    if(p->state == RUNNABLE && allowed(p, id)){
+      e = effprio(p);
+      if(e > baseprio(p) && e >= prio){
+        run(c, p);
+        found = 1;
+      }
+    }
+    release(&p->lock);
+  }
+  return found;
+}
+
+// The caller is about to sleep on a sleeplock held by process
+// holder, to which the lock currently lends priority donated
+// (0 if none). Lend the caller's priority instead if it is
+// higher, counting an inversion if the holder was running at a
+// lower priority than the caller. Returns what the lock lends now.
+// Caller holds the sleeplock's spinlock.
+int
+pi_wait(int holder, int donated)
+{
+  struct proc *me = myproc();
+  struct proc *p;
+  int mine;
+
+  acquire(&me->lock);
+  mine = effprio(me);
+  release(&me->lock);
+  if(mine <= donated)
+    return donated;
+
+  for(p = proc; p < &proc[NPROC]; p++){
+    acquire(&p->lock);
+    if(p->pid == holder && p->state != UNUSED){
+      if(effprio(p) < mine)
+        me->inversions++;
+      if(donated)
+        p->pi_boost[donated]--;
+      p->pi_boost[mine]++;
+      release(&p->lock);
+      return mine;
+    }
+    release(&p->lock);
+  }
+  return donated;
+}
+
+// The caller is releasing a sleeplock that lent it priority
+// donated (0 if none).
+void
+pi_release(int donated)
+{
+  struct proc *p = myproc();
+
+  if(donated == 0)
+    return;
+  acquire(&p->lock);
+  p->pi_boost[donated]--;
+  release(&p->lock);
+}
+
+// Can round-robin on CPU id pick p? With steal clear, only if
+// this is p's home CPU.
+static int
+eligible(struct proc *p, int id, int steal)
+{
+  return p->state == RUNNABLE && allowed(p, id) && (steal || home(p, id));
+}
+
+// The first level of fair-share round-robin: of the groups with
+// a process eligible to run here, the one that has had the least
+// CPU for its share. Returns -1 if nothing is eligible.
+static int
+pickgroup(int id, int steal)
+{
+  struct proc *p;
+  int ready[NSGROUP];
+  int g, best = -1;
+
+  memset(ready, 0, sizeof(ready));
+  for(p = proc; p < &proc[NPROC]; p++){
+    acquire(&p->lock);
+    if(eligible(p, id, steal))
+      ready[p->sgid] = 1;
+    release(&p->lock);
+  }
+
+  acquire(&sg_lock);
+  for(g = 0; g < NSGROUP; g++)
+    if(ready[g] && (best < 0 || sgroups[g].vruntime < sgroups[best].vruntime))
+      best = g;
+  release(&sg_lock);
+  return best;
+}
+
+// The second level: the next eligible process of group g,
+// round-robin from where the group last left off, returned
+// locked, or 0. A process with positive nice passes over skips()
+// turns after each one it takes, unless it is the only choice.
+static struct proc*
+pickingroup(int g, int id, int steal)
+{
+  struct proc *p;
+  int i, pass, start = sgroups[g].next;
+
+  for(pass = 0; pass < 2; pass++){
+    for(i = 1; i <= NPROC; i++){
+      p = &proc[(start + i) % NPROC];
+      acquire(&p->lock);
+      if(p->sgid == g && eligible(p, id, steal)){
+        if(pass == 0 && p->skip > 0){
+          p->skip--;
+        } else {
+          sgroups[g].next = p - proc;
+          p->advised = 0;
+          p->skip = skips(p);
+          return p;
+        }
+      }
+      release(&p->lock);
+    }
+  }
+  return 0;
+}
+
+// SCHED_RR: fair-share round-robin. Pick a group, then a process
+// in it. Processes whose home is this CPU go first, and only if
+// there are none does this CPU take any process allowed here
+// (it steals).
+static struct proc*
+rr_pick(int id)
+{
+  struct proc *p;
+  int g;
+
+  for(int steal = 0; steal < 2; steal++){
+    if((g = pickgroup(id, steal)) >= 0 && (p = pickingroup(g, id, steal)) != 0)
+      return p;
+  }
+  return 0;
+}
+
+// Called on each timer tick p is running; nonzero once p has
+// used up its quantum (see quantum()).
+static int
+rr_tick(struct proc *p)
+{
+  return --p->slice <= 0;
+}
+
+// SCHED_ADVISED: the process the LLM advised, if it's runnable
+// here, else round-robin. Advice naming a gang (a negative
+// "pid") picks any runnable member of it, which opens the gang's
+// slot for the rest. Each piece of advice is used once.
+static struct proc*
+advised_pick(int id)
+{
+  struct proc *p;
+  int advised_pid = 0;
+
+  // Snapshot any current LLM advice under its own lock.
+  acquire(&llm_lock);
+  if(llm_advice_valid &&
+     (ticks - llm_advice_timestamp) < ADVICE_TIMEOUT_TICKS)
+    advised_pid = llm_recommended_pid;
+  release(&llm_lock);
+
+  if(advised_pid != 0){
+    for(p = proc; p < &proc[NPROC]; p++) {
+      acquire(&p->lock);
+      if(p->state == RUNNABLE && allowed(p, id) &&
+         (advised_pid > 0 ? p->pid == advised_pid : p->gang == -advised_pid)) {
+        // Mark this advice as used so the agent can provide fresh input.
+        acquire(&llm_lock);
+        llm_advice_valid = 0;
+        release(&llm_lock);
+
+        p->advised = 1;
+        return p;
+      }
+      release(&p->lock);
+    }
+  }
+  return rr_pick(id);
+}
+
+static void
+advised_advice(int pid)
+{
+  acquire(&llm_lock);
+  llm_recommended_pid  = pid;
+  llm_advice_valid     = 1;
+  llm_advice_timestamp = ticks;
+  release(&llm_lock);
+}
+
+static struct schedpolicy policies[NSCHEDPOLICY] = {
+  [SCHED_RR]      = { "rr", 1, 0, 0, rr_pick, rr_tick, 0 },
+  [SCHED_ADVISED] = { "advised", 1, 0, 0, advised_pick, rr_tick, advised_advice },
+};
+
+// Index into policies[]; read without a lock, but only changed
+// by setschedpolicy() under each RUNNABLE process's lock (see
+// there), and read under that lock by enqueue() and dequeue().
+static int curpolicy = SCHED_ADVISED;
+
+static struct schedpolicy*
+policy(void)
+{
+  return &policies[__atomic_load_n(&curpolicy, __ATOMIC_RELAXED)];
+}
+
+// Tell the policy p has become RUNNABLE. p->lock must be held.
+static void
+enqueue(struct proc *p)
+{
+  struct schedpolicy *sp = policy();
+
+  if(sp->enqueue)
+    sp->enqueue(p);
+}
+
+// Tell the policy p is no longer RUNNABLE. p->lock must be held.
+static void
+dequeue(struct proc *p)
+{
+  struct schedpolicy *sp = policy();
+
+  if(sp->dequeue)
+    sp->dequeue(p);
+}
+
+// Make p RUNNABLE. p->lock must be held.
+static void
+setrunnable(struct proc *p)
+{
+  p->state = RUNNABLE;
+  enqueue(p);
+}
+
+// Called from the timer interrupt while p is running: should
+// p give up the CPU now?
+int
+schedtick(struct proc *p)
+{
+  return policy()->tick(p);
+}
+
+// Switch every CPU to scheduling policy id (SCHED_* in
+// schedpolicy.h), handing RUNNABLE processes over from the old
+// one. id < 0 just asks. Returns the previous policy, or -1 if
+// id is out of range.
+int
+setschedpolicy(int id)
+{
+  struct schedpolicy *old;
+  struct proc *p;
+  int prev;
+
+  prev = __atomic_load_n(&curpolicy, __ATOMIC_RELAXED);
+  if(id < 0)
+    return prev;
+  if(id >= NSCHEDPOLICY)
+    return -1;
+
+  acquire(&policy_lock);
+  prev = curpolicy;
+  old = &policies[prev];
+  __atomic_store_n(&curpolicy, id, __ATOMIC_RELAXED);
+  if(id != prev){
+    for(p = proc; p < &proc[NPROC]; p++){
+      acquire(&p->lock);
+      if(p->state == RUNNABLE){
+        if(old->dequeue)
+          old->dequeue(p);
+        enqueue(p);
+      }
+      release(&p->lock);
+    }
+  }
+  release(&policy_lock);
+  return prev;
+}
+
+// Open the slot for p's gang, which is about to run for a
+// quantum, unless a slot is still open: there is only one, and
+// taking it over would cut the open gang's quantum short.
+// p->lock must be held.
+static void
+gangstart(struct proc *p)
+{
+  acquire(&gang_lock);
+  if(gang_slot == 0 || (int)(gang_until - ticks) <= 0){
+    gang_slot = p->gang;
+    gang_until = ticks + quantum(p);
+  }
+  release(&gang_lock);
+}
+
+// A RUNNABLE member of the gang whose slot is open, allowed on
+// CPU id, returned locked, or 0.
+static struct proc*
+gangpick(int id)
+{
+  struct proc *p;
+  int gang;
+
+  acquire(&gang_lock);
+  gang = (int)(gang_until - ticks) > 0 ? gang_slot : 0;
+  release(&gang_lock);
+  if(gang == 0)
+    return 0;
+
+  for(p = proc; p < &proc[NPROC]; p++){
+    acquire(&p->lock);
+    if(p->gang == gang && p->state == RUNNABLE && allowed(p, id))
+      return p;
+    release(&p->lock);
+  }
+  return 0;
+}
+
+// Set the starvation bound to ticks (0 turns the guard off);
+// ticks < 0 just asks. Returns the previous bound.
+int
+setstarvebound(int ticks)
+{
+  int old;
+
+  acquire(&starve_lock);
+  old = starve_bound;
+  if(ticks >= 0)
+    starve_bound = ticks;
+  release(&starve_lock);
+  return old;
+}
+
+// The starvation guard: the user process allowed on CPU id that
+// has been RUNNABLE longest, if that's at least starve_bound
+// ticks, returned locked, or 0. Records the event.
+static struct proc*
+starving(int id)
+{
+  struct proc *p, *worst = 0;
+  int bound, waited = 0;
+
+  acquire(&starve_lock);
+  bound = starve_bound;
+  release(&starve_lock);
+  if(bound == 0)
+    return 0;
+
+  for(p = proc; p < &proc[NPROC]; p++){
+    acquire(&p->lock);
+    if(!p->kthread && p->state == RUNNABLE && allowed(p, id) &&
+       p->curwait >= bound && p->curwait > waited){
+      worst = p;
+      waited = p->curwait;
+    }
+    release(&p->lock);
+  }
+  if(worst == 0)
+    return 0;
+
+  acquire(&worst->lock);
+  // it may have been run elsewhere since the scan.
+  if(worst->state != RUNNABLE || worst->curwait < bound){
+    release(&worst->lock);
+    return 0;
+  }
+
+  struct starve e;
+  e.tick = ticks;
+  e.pid = worst->pid;
+  e.waited = worst->curwait;
+  acquire(&llm_lock);
+  e.advice = llm_advice_valid && (ticks - llm_advice_timestamp) < ADVICE_TIMEOUT_TICKS ?
+             llm_recommended_pid : 0;
+  release(&llm_lock);
+  acquire(&starve_lock);
+  starvelog[nstarve++ % NSTARVE] = e;
+  release(&starve_lock);
+  return worst;
+}
+
+// Per-CPU process scheduler.
+// Each CPU calls scheduler() after setting itself up.
+// Scheduler never returns.  It loops, doing:
+//  - choose a process to run: kernel threads, then processes
+//    holding a lock a real-time one waits for, then the
+//    real-time class, then any process that has waited past the
+//    starvation bound, then other boosted lock holders, then the
+//    open gang, then whatever the current policy picks;
+//  - swtch to start running that process;
+//  - eventually that process transfers control
+//    via swtch back to the scheduler.
+void
+scheduler(void)
+{
+  struct proc *p;
+  struct cpu *c = mycpu();
+  int id = cpuid();
+
+  c->proc = 0;
+  __atomic_fetch_or(&cpus_online, 1 << id, __ATOMIC_RELAXED);
+  for(;;){
+    // The most recent process to run may have had interrupts
+    // turned off; enable them to avoid a deadlock if all
+    // processes are waiting. Then turn them back off
+    // to avoid a possible race between an interrupt
+    // and wfi.
+    intr_on();
+    intr_off();
+
+    int found = 0;
+
+    // Kernel threads are their own class, ahead of advice and
+    // round-robin: they run short bursts of deferred work and
+    // then sleep, so they can't starve user processes.
+    for(p = proc; p < &proc[NPROC]; p++) {
+      acquire(&p->lock);
+      if(p->kthread && p->state == RUNNABLE && allowed(p, id)) {
+        run(c, p);
+        found = 1;
+      }
+      release(&p->lock);
+    }
+    if(found)
+      continue;
+
+    // Priority inheritance: a process holding a sleeplock that a
+    // real-time process waits for runs with that process's class.
+    if(runboosted(c, id, PRIO_RT))
+      continue;
+
+    // Real-time class, ahead of advice and round-robin: earliest
+    // deadline first among processes with budget left in their
+    // current period. Once a period's budget is spent, a process
+    // competes like any other until its next period.
+    struct proc *rt = 0;
+    for(p = proc; p < &proc[NPROC]; p++) {
+      acquire(&p->lock);
+      if(p->rt && p->state == RUNNABLE && p->rt_budget > 0 && allowed(p, id) &&
+         (rt == 0 || (int)(p->rt_dl - rt->rt_dl) < 0))
+        rt = p;
+      release(&p->lock);
+    }
+    if(rt){
+      acquire(&rt->lock);
+      // it may have been run elsewhere since the scan.
+      if(rt->rt && rt->state == RUNNABLE && rt->rt_budget > 0)
+        run(c, rt);
+      release(&rt->lock);
+      continue;
+    }
+
+    // Forward progress: a process that has waited too long runs
+    // now, ahead of advice and the policy. Real-time reservations
+    // still come first, so admission control's guarantee holds.
+    if((p = starving(id)) != 0){
+      run(c, p);
+      release(&p->lock);
+      continue;
+    }
+
+    // Holders lent a lower, advised, priority run after the
+    // real-time class but ahead of advice and round-robin.
+    if(runboosted(c, id, PRIO_ADVISED))
+      continue;
+
+    // While a gang's slot is open, its members run here too.
+    if((p = gangpick(id)) != 0){
+      run(c, p);
+      release(&p->lock);
+      continue;
+    }
+
+    // Everything else is up to the current policy. Picking a
+    // gang member opens its gang's slot for the other harts.
+    if((p = policy()->pick_next(id)) != 0){
+      if(p->gang)
+        gangstart(p);
+      run(c, p);
+      release(&p->lock);
+      found = 1;
+    }
+
+    if(found == 0) {
+      // nothing to run; stop running on this core until an interrupt.
+      asm volatile("wfi");
+    }
+  }
+}
+
+// Switch to scheduler.  Must hold only p->lock
+// and have changed proc->state. Saves and restores
+// intena because intena is a property of this
+// kernel thread, not this CPU. It should
+// be proc->intena and proc->noff, but that would
+// break in the few places where a lock is held but
+// there's no process.
+void
+sched(void)
+{
+  int intena;
+  struct proc *p = myproc();
+
+  if(!holding(&p->lock))
+    panic("sched p->lock");
+  if(mycpu()->noff != 1)
+    panic("sched locks");
+  if(p->state == RUNNING)
+    panic("sched RUNNING");
+  if(intr_get())
+    panic("sched interruptible");
+
+  // yield() counts its own switches, which may go either way.
+  if(p->state == SLEEPING)
+    p->nvcsw++;
+
+  intena = mycpu()->intena;
+  swtch(&p->context, &mycpu()->context);
+  mycpu()->intena = intena;
+}
+
+// Give up the CPU for one scheduling round. forced is set
+// when the time slice ran out or kick() asked, an involuntary
+// switch; otherwise the process chose to go.
+static void
+yield1(int forced)
+{
+  struct proc *p = myproc();
+  acquire(&p->lock);
+  if(forced)
+    p->nivcsw++;
+  else
+    p->nvcsw++;
+  setrunnable(p);
+  sched();
+  release(&p->lock);
+}
+
+// Give up the CPU of the process's own accord: the yield()
+// system call, or moving off a CPU setaffinity() ruled out.
+void
+yield(void)
+{
+  yield1(0);
+}
+
+// Give up the CPU because the scheduler says so: the time
+// slice ran out, or kick() wants the CPU for someone else.
+void
+yield_preempted(void)
+{
+  yield1(1);
+}
+
+// A fork child's very first scheduling by scheduler()
+// will swtch to forkret.
+void
+forkret(void)
+{
+  extern char userret[];
+  static int first = 1;
+  struct proc *p = myproc();
+
+  // Still holding p->lock from scheduler.
+  release(&p->lock);
+
+  if (first) {
+    // File system initialization must be run in the context of a
+    // regular process (e.g., because it calls sleep), and thus cannot
+    // be run from main().
+    fsinit(ROOTDEV);
+
+    first = 0;
+    // make other cores see first=0.
+    __sync_synchronize();
+
+    // We can invoke kexec() now that file system is initialized.
+    // Put the return value (argc) of kexec into a0.
+    p->trapframe->a0 = kexec("/init", (char *[]){ "/init", 0 });
+    if (p->trapframe->a0 == -1) {
+      panic("exec");
+    }
+  }
+
+  // return to user space, mimicing usertrap()'s return.
+  prepare_return();
+  uint64 satp = MAKE_SATP(p->pagetable);
+  uint64 trampoline_userret = TRAMPOLINE + (userret - trampoline);
+  ((void (*)(uint64))trampoline_userret)(satp);
+}
+
+// A kernel thread's very first scheduling by scheduler()
+// will swtch to kthreadret, which runs the thread's function.
+static void
+kthreadret(void)
+{
+  struct proc *p = myproc();
+
+  // Still holding p->lock from scheduler.
+  release(&p->lock);
+
+  // scheduler() runs with interrupts off, and there's no
+  // return to user space to turn them back on.
+  intr_on();
+
+  p->kfn();
+  panic("kthread returned");
+}
+
+// Sleep on channel chan, releasing condition lock lk.
+// Re-acquires lk when awakened.
+void
+sleep(void *chan, struct spinlock *lk)
+{
+  struct proc *p = myproc();
+
+  // Must acquire p->lock in order to
+  // change p->state and then call sched.
+  // Once we hold p->lock, we can be
+  // guaranteed that we won't miss any wakeup
+  // (wakeup locks p->lock),
+  // so it's okay to release lk.
+
+  acquire(&p->lock);  //DOC: sleeplock1
+  release(lk);
+
+  // Go to sleep.
+  p->chan = chan;
+  p->state = SLEEPING;
+
+  sched();
+
+  // Tidy up.
+  p->chan = 0;
+
+  // Reacquire original lock.
+  release(&p->lock);
+  acquire(lk);
+}
+
+// Sleep for n clock ticks, or until killed.
+// Returns 0, or -1 if the process was killed.
+int
+kpause(int n)
+{
+  uint ticks0;
+  struct proc *p = myproc();
+
+  // Count pause as an I/O-style blocking event so the scheduler
+  // can treat it like a simple sleep-like syscall.
+  p->io_count++;
+
+  if(n < 0)
+    n = 0;
+  acquire(&tickslock);
+  ticks0 = ticks;
+  while(ticks - ticks0 < (uint)n){
+    if(killed(p)){
+      release(&tickslock);
+      return -1;
+    }
+    sleep(&ticks, &tickslock);
+  }
+  release(&tickslock);
+  return 0;
+}
+
+// Make CPU id reschedule now: interrupt it through the CLINT,
+// which ipivec (kernelvec.S) turns into a supervisor software
+// interrupt, on which usertrap() and kerneltrap() yield.
+static void
+kick(int id)
+{
+  *(volatile uint32 *)CLINT_MSIP(id) = 1;
+}
+
+// p, which is locked, has just woken up. Rather than leave it
+// waiting for a CPU's next timer tick, kick an idle CPU it may
+// run on, or else the one running the least important process
+// if that's less important than p, or than the LLM advised p
+// to be, naming it or its gang. Counts the kicks in npreempts,
+// or in nidlekicks if the CPU was idle.
+static void
+preempt(struct proc *p)
+{
+  int prio, id, target = -1, idle = 0;
+
+  if(p->kthread)
+    return;
+  prio = effprio(p);
+  acquire(&llm_lock);
+  if(prio < PRIO_ADVISED && llm_advice_valid &&
+     (llm_recommended_pid == p->pid ||
+      (p->gang != 0 && llm_recommended_pid == -p->gang)) &&
+     (ticks - llm_advice_timestamp) < ADVICE_TIMEOUT_TICKS)
+    prio = PRIO_ADVISED;
+  release(&llm_lock);
+
+  for(id = 0; id < NCPU; id++){
+    struct cpu *c = &cpus[id];
+    if((cpus_online & (1 << id)) == 0 || !allowed(p, id))
+      continue;
+    if(c->proc == 0){
+      target = id;
+      idle = 1;
+      break;
+    }
+    if(c->prio < prio && (target < 0 || c->prio < cpus[target].prio))
+      target = id;
+  }
+  if(target >= 0){
+    kick(target);
+    if(idle)
+      __atomic_fetch_add(&nidlekicks, 1, __ATOMIC_RELAXED);
+    else
+      __atomic_fetch_add(&npreempts, 1, __ATOMIC_RELAXED);
+  }
+}
+
+// Wake up all processes sleeping on channel chan.
+// Caller should hold the condition lock.
+void
+wakeup(void *chan)
 {
   struct proc *p;
 
@@ -654,7 +1968,8 @@ wakeup(void *chan)
     if(p != myproc()){
       acquire(&p->lock);
       if(p->state == SLEEPING && p->chan == chan) {
-        p->state = RUNNABLE;
+        setrunnable(p);
+        preempt(p);
       }
       release(&p->lock);
     }
@@ -671,11 +1986,11 @@ kkill(int pid)
 
   for(p = proc; p < &proc[NPROC]; p++){
     acquire(&p->lock);
-    if(p->pid == pid){
+    if(p->pid == pid && !p->kthread){
       p->killed = 1;
       if(p->state == SLEEPING){
         // Wake process from sleep().
-        p->state = RUNNABLE;
+        setrunnable(p);
       }
       release(&p->lock);
       return 0;
@@ -734,27 +2049,134 @@ either_copyin(void *dst, int user_src, uint64 src, uint64 len)
   }
 }
 
+// Record LLM advice for the scheduler. Called from
+// sys_set_llm_advice() and from batched advice in uring.c.
+// A negative pid names gang -pid instead of a process.
+// Returns 0, or -1 if pid is 0; the policy does the final
+// validation.
+int
+set_llm_advice(int pid)
+{
+  struct schedpolicy *sp = policy();
+
+  if(pid == 0)
+    return -1;
+
+  // a policy that takes no advice drops it.
+  if(sp->on_advice)
+    sp->on_advice(pid);
+  return 0;
+}
+
+// Copy the system call statistics of process pid, or the
+// system-wide totals if pid is 0, to user address addr.
+// Returns 0, or -1 if there is no such process or addr is bad.
+int
+procsysstat(int pid, uint64 addr)
+{
+  struct proc *p;
+  struct proc *me = myproc();
+  char buf[128];
+  int off, n;
+
+  if(pid == 0)
+    return copyout(me->pagetable, addr, (char *)&sysstat_total,
+                   sizeof(sysstat_total));
+
+  for(p = proc; p < &proc[NPROC]; p++)
+    if(p->pid == pid)
+      break;
+  if(p == &proc[NPROC])
+    return -1;
+
+  // A chunk at a time through buf: copyout() may fault in and
+  // allocate a page, which it mustn't do under p->lock, and the
+  // whole struct is too big for the kernel stack.
+  for(off = 0; off < sizeof(p->sysstat); off += n){
+    n = sizeof(p->sysstat) - off;
+    if(n > sizeof(buf))
+      n = sizeof(buf);
+    acquire(&p->lock);
+    if(p->pid != pid || p->state == UNUSED){
+      release(&p->lock);
+      return -1;
+    }
+    memmove(buf, (char *)&p->sysstat + off, n);
+    release(&p->lock);
+    if(copyout(me->pagetable, addr + off, buf, n) < 0)
+      return -1;
+  }
+  return 0;
+}
+
 // Update per-process scheduling statistics on each timer tick.
 // Called from clockintr() on CPU 0. Assumes a single-CPU
 // configuration (CPUS=1) for this project.
+// Also publishes the new tick count in each process's
+// usyscall page, for the trap-free uptime() in ulib.c.
 void
 update_sched_stats(void)
 {
   struct proc *p;
+  int running[NSGROUP], waiting[NSGROUP];
+  uint64 minv = 0;
+  int g, active = 0;
+
+  memset(running, 0, sizeof(running));
+  memset(waiting, 0, sizeof(waiting));
 
   for(p = proc; p < &proc[NPROC]; p++) {
     acquire(&p->lock);
+    if(p->usyscall)
+      p->usyscall->ticks = ticks;
     if(p->state == RUNNABLE) {
       // Runnable but not running: waiting for CPU.
       p->wait_ticks++;
+      if(++p->curwait > p->maxwait)
+        p->maxwait = p->curwait;
+      if(!p->kthread)
+        waiting[p->sgid]++;
     } else if(p->state == RUNNING) {
       // Currently running process accrues CPU time.
       p->cpu_ticks++;
       p->recent_cpu++;
+      if(p->rt && p->rt_budget > 0)
+        p->rt_budget--;
+      if(!p->kthread)
+        running[p->sgid]++;
+    }
+    if(p->rt && (int)(ticks - p->rt_next) >= 0){
+      // Start the next real-time period, or, if the process
+      // slept through more than one, a fresh one from now.
+      if((int)(ticks - p->rt_next) >= (int)p->rt_period)
+        p->rt_next = ticks;
+      p->rt_budget = p->rt_runtime;
+      p->rt_dl = p->rt_next + p->rt_deadline;
+      p->rt_next += p->rt_period;
     }
     // io_count is updated elsewhere (for example, in blocking syscalls).
     release(&p->lock);
   }
+
+  // Charge each group for its running processes. A group with
+  // nothing runnable is pulled up to the least vruntime of the
+  // busy ones, so it can't bank idle time and then hog the CPU.
+  acquire(&sg_lock);
+  for(g = 0; g < NSGROUP; g++){
+    struct schedgroup *sg = &sgroups[g];
+    sg->cpu_ticks += running[g];
+    sg->wait_ticks += waiting[g];
+    sg->vruntime += (uint64)running[g] * SG_SCALE / sg->share;
+    if(running[g] + waiting[g] > 0){
+      if(!active || sg->vruntime < minv)
+        minv = sg->vruntime;
+      active = 1;
+    }
+  }
+  for(g = 0; g < NSGROUP; g++)
+    if(active && running[g] + waiting[g] == 0 && sgroups[g].vruntime < minv)
+      sgroups[g].vruntime = minv;
+  release(&sg_lock);
 }
 
 // Emit a structured snapshot of the scheduler state.
@@ -762,56 +2184,211 @@ update_sched_stats(void)
 //
 //   SCHED_LOG_START
 //   TIMESTAMP:<ticks>
-//   PROC:<pid>,<state>,<cpu_ticks>,<wait_ticks>,<io_count>,<recent_cpu>
+//   POLICY:<name>,<slice>
+//   PREEMPT:<preempts>,<idlekicks>
+//   STARVE:<tick>,<pid>,<waited>,<advice>
+//   ...
+//   PROC:<pid>,<state>,<cpu_ticks>,<wait_ticks>,<io_count>,<recent_cpu>,<flags>,<lastcpu>,<migrations>,<group>,<lockwait>,<inversions>,<nice>,<vcsw>,<ivcsw>,<timeslice>,<gang>,<maxwait>
+//   ...
+//   GROUP:<gid>,<share>,<nproc>,<cpu_ticks>,<wait_ticks>
+//   ...
+//   GANG:<id>,<nmembers>,<skew>
 //   ...
 //   SCHED_LOG_END
 //
+// flags is a bitmask of SCHED_FLAG_* (proc.h). lastcpu is the
+// hart the process last ran on (-1 if none yet), and migrations
+// counts dispatches on a different hart than the previous one.
+// lockwait is ticks spent waiting for sleeplocks (not counted
+// in io_count), and inversions counts those waits that found the
+// holder at a lower priority (see pi_wait()). nice is the
+// setpriority() value, -20 (favoured) .. 19. vcsw and ivcsw
+// count switches away from the process to sleep or yield() and
+// by preemption, and timeslice is its settimeslice() quantum (0
+// if it uses the policy's). gang is the setgang() gang, 0 if none.
+// maxwait is the longest it has been RUNNABLE without running.
+// GROUP lines cover scheduling groups with members or history.
+// GANG lines cover gangs in use or with a finished round; skew
+// is ticks between its first and last member leaving in the
+// last complete round (-1 if none has completed).
+// POLICY names the current setschedpolicy() policy and its
+// default time slice. PREEMPT counts wakeups that kicked a CPU
+// to reschedule at once (see preempt()): preempts interrupted a
+// less important running process, idlekicks only woke an idle
+// CPU. A STARVE line is printed for each time since the last
+// log that the starvation guard ran pid after waited ticks,
+// overriding advice (the pid advised then, -gang for a gang, or
+// 0 if none).
+//
+// Only schedlogd calls this, so the per-process snapshot can
+// live in a static buffer rather than on its one-page stack.
+static struct {
+  int pid;
+  int state;
+  int cpu_ticks;
+  int wait_ticks;
+  int io_count;
+  int recent_cpu;
+  int flags;
+  int lastcpu;
+  int migrations;
+  int sgid;
+  int lockwait;
+  int inversions;
+  int nice;
+  int nvcsw;
+  int nivcsw;
+  int timeslice;
+  int gang;
+  int maxwait;
+} schedsnap[NPROC];
+
 void
 log_scheduling_state(void)
 {
   struct proc *p;
 
-  // Local snapshot to avoid holding locks while printing.
-  struct {
-    int pid;
-    int state;
-    int cpu_ticks;
-    int wait_ticks;
-    int io_count;
-    int recent_cpu;
-  } snap[NPROC];
+  // Snapshot to avoid holding locks while printing.
+  struct starve ssnap[NSTARVE];
+  int nss = 0;
+  struct schedgroup gsnap[NSGROUP];
+  struct gang gangsnap[NGANG];
+  int nproc[NSGROUP];
   int count = 0;
 
+  // keep what is left of the frame well inside KSTACK's page.
+  _Static_assert(sizeof(ssnap) + sizeof(gsnap) + sizeof(gangsnap) +
+                 sizeof(nproc) <= PGSIZE / 4,
+                 "log_scheduling_state: frame too big");
+  memset(nproc, 0, sizeof(nproc));
+
   for(p = proc; p < &proc[NPROC]; p++) {
     acquire(&p->lock);
     if(p->state != UNUSED) {
       if(count < NPROC) {
-        snap[count].pid         = p->pid;
-        snap[count].state       = p->state;
-        snap[count].cpu_ticks   = p->cpu_ticks;
-        snap[count].wait_ticks  = p->wait_ticks;
-        snap[count].io_count    = p->io_count;
-        snap[count].recent_cpu  = p->recent_cpu;
+        schedsnap[count].pid         = p->pid;
+        schedsnap[count].state       = p->state;
+        schedsnap[count].cpu_ticks   = p->cpu_ticks;
+        schedsnap[count].wait_ticks  = p->wait_ticks;
+        schedsnap[count].io_count    = p->io_count;
+        schedsnap[count].recent_cpu  = p->recent_cpu;
+        schedsnap[count].flags       = (p->kthread ? SCHED_FLAG_KTHREAD : 0) |
+                                       (p->leader ? SCHED_FLAG_THREAD : 0) |
+                                       (p->rt ? SCHED_FLAG_RT : 0);
+        schedsnap[count].lastcpu     = p->lastcpu;
+        schedsnap[count].migrations  = p->migrations;
+        schedsnap[count].sgid        = p->sgid;
+        schedsnap[count].lockwait    = p->lockwait_ticks;
+        schedsnap[count].inversions  = p->inversions;
+        schedsnap[count].nice        = p->nice;
+        schedsnap[count].nvcsw       = p->nvcsw;
+        schedsnap[count].nivcsw      = p->nivcsw;
+        schedsnap[count].timeslice   = p->timeslice;
+        schedsnap[count].gang        = p->gang;
+        schedsnap[count].maxwait     = p->maxwait;
+        if(!p->kthread)
+          nproc[p->sgid]++;
         count++;
       }
     }
     release(&p->lock);
   }
 
+  acquire(&sg_lock);
+  memmove(gsnap, sgroups, sizeof(gsnap));
+  release(&sg_lock);
+  acquire(&gang_lock);
+  memmove(gangsnap, gangs, sizeof(gangsnap));
+  release(&gang_lock);
+  acquire(&starve_lock);
+  if(nstarve - starve_logged > NSTARVE)
+    starve_logged = nstarve - NSTARVE;
+  for(; starve_logged < nstarve; starve_logged++)
+    ssnap[nss++] = starvelog[starve_logged % NSTARVE];
+  release(&starve_lock);
+
   printf("SCHED_LOG_START\n");
   printf("TIMESTAMP:%u\n", ticks);
+  printf("POLICY:%s,%d\n", policy()->name, policy()->slice);
+  printf("PREEMPT:%d,%d\n", __atomic_load_n(&npreempts, __ATOMIC_RELAXED),
+         __atomic_load_n(&nidlekicks, __ATOMIC_RELAXED));
+  for(int i = 0; i < nss; i++)
+    printf("STARVE:%u,%d,%d,%d\n",
+           ssnap[i].tick, ssnap[i].pid, ssnap[i].waited, ssnap[i].advice);
   for(int i = 0; i < count; i++) {
-    printf("PROC:%d,%d,%d,%d,%d,%d\n",
-           snap[i].pid,
-           snap[i].state,
-           snap[i].cpu_ticks,
-           snap[i].wait_ticks,
-           snap[i].io_count,
-           snap[i].recent_cpu);
+    printf("PROC:%d,%d,%d,%d,%d,%d,%d,%d,%d,%d,%d,%d,%d,%d,%d,%d,%d,%d\n",
+           schedsnap[i].pid,
+           schedsnap[i].state,
+           schedsnap[i].cpu_ticks,
+           schedsnap[i].wait_ticks,
+           schedsnap[i].io_count,
+           schedsnap[i].recent_cpu,
+           schedsnap[i].flags,
+           schedsnap[i].lastcpu,
+           schedsnap[i].migrations,
+           schedsnap[i].sgid,
+           schedsnap[i].lockwait,
+           schedsnap[i].inversions,
+           schedsnap[i].nice,
+           schedsnap[i].nvcsw,
+           schedsnap[i].nivcsw,
+           schedsnap[i].timeslice,
+           schedsnap[i].gang,
+           schedsnap[i].maxwait);
+  }
+  for(int g = 0; g < NSGROUP; g++) {
+    if(nproc[g] == 0 && gsnap[g].cpu_ticks == 0)
+      continue;
+    printf("GROUP:%d,%d,%d,%d,%d\n",
+           g, gsnap[g].share, nproc[g], gsnap[g].cpu_ticks, gsnap[g].wait_ticks);
+  }
+  for(int g = 0; g < NGANG; g++) {
+    if(gangsnap[g].id == 0)
+      continue;
+    printf("GANG:%d,%d,%d\n",
+           gangsnap[g].id, gangsnap[g].nmembers, gangsnap[g].skew);
   }
   printf("SCHED_LOG_END\n");
 }
 
+// Set every LOG_INTERVAL ticks by clockintr(), cleared by
+// schedlogd once it has printed a snapshot.
+// Protected by tickslock.
+static int schedlog_pending;
+
+// Ask schedlogd for a SCHED_LOG snapshot.
+// Caller must hold tickslock.
+void
+schedlog_request(void)
+{
+  schedlog_pending = 1;
+  wakeup(&schedlog_pending);
+}
+
+// Kernel thread that prints SCHED_LOG snapshots, so that the
+// slow console output doesn't happen inside the timer interrupt.
+static void
+schedlogd(void)
+{
+  for(;;){
+    acquire(&tickslock);
+    while(schedlog_pending == 0)
+      sleep(&schedlog_pending, &tickslock);
+    schedlog_pending = 0;
+    release(&tickslock);
+
+    log_scheduling_state();
+  }
+}
+
+// Start the SCHED_LOG kernel thread. Called once from main().
+void
+schedloginit(void)
+{
+  if(kthread_create("schedlogd", schedlogd) < 0)
+    panic("schedloginit");
+}
+
 // Print a process listing to console.  For debugging.
 // Runs when user types ^P on console.
 // No lock to avoid wedging a stuck machine further.
@@ -24,13 +24,17 @@ struct cpu {
   struct context context;     // swtch() here to enter scheduler().
   int noff;                   // Depth of push_off() nesting.
   int intena;                 // Were interrupts enabled before push_off()?
+  int prio;                   // effprio() of proc when dispatched (see kick())
 };
 
 extern struct cpu cpus[NCPU];
 
 // per-process data for the trap handling code in trampoline.S.
 // sits in a page by itself just under the trampoline page in the
-// user page table. not specially mapped in the kernel page table.
+// user page table, or, for a clone()d thread, in a THREADTF() page
+// of the page table it shares; p->tfva says which, and
+// prepare_return() hands it to trampoline.S in sscratch.
+// not specially mapped in the kernel page table.
 // uservec in trampoline.S saves user registers in the trapframe,
 // then initializes registers from the trapframe's
 // kernel_sp, kernel_hartid, kernel_satp, and jumps to kernel_trap.
@@ -81,6 +85,83 @@ struct trapframe {
 
 enum procstate { UNUSED, USED, SLEEPING, RUNNABLE, RUNNING, ZOMBIE };
 
+// Priorities for sleeplock priority inheritance: a waiter lends
+// its priority to the lock's holder (see pi_wait()).
+#define PRIO_NORMAL   0
+#define PRIO_ADVISED  1   // most recently dispatched on LLM advice
+#define PRIO_RT       2   // real-time class
+#define NPRIO         3
+
+// Range of nice values (getpriority/setpriority). Lower is more
+// important: negative nice lengthens a process's quantum, and
+// positive nice makes round-robin pass it over some turns.
+#define NICE_MIN  -20
+#define NICE_MAX   19
+
+// Longest time slice settimeslice() accepts, in ticks.
+#define SLICE_MAX  100
+
+// Default starvation bound (see setstarvebound()), in ticks.
+#define STARVE_DEFAULT  30
+
+// A process the starvation guard ran (see scheduler()).
+struct starve {
+  uint tick;                   // When
+  int pid;                     // Who
+  int waited;                  // Ticks it had been RUNNABLE
+  int advice;                  // Advice pending then (-gang for a gang),
+                               // or 0 if none
+};
+
+// Every CPU, the affinity of a new process.
+#define AFFINITY_ALL  ((1 << NCPU) - 1)
+
+// A scheduling group. round-robin shares the CPU between groups
+// in proportion to their share, then between a group's processes.
+struct schedgroup {
+  int share;                   // Relative CPU share
+  uint64 vruntime;             // CPU ticks received, scaled by 1/share
+  int cpu_ticks;               // Ticks its processes ran
+  int wait_ticks;              // Ticks its processes waited RUNNABLE
+  int next;                    // proc[] index to continue round-robin after
+                               // (a hint; read and set without sg_lock)
+};
+
+#define SG_DEFAULT_SHARE  100
+#define SG_MAX_SHARE      10000
+
+// A gang: processes that harts run side by side (see setgang()).
+// A round ends when its last member leaves; skew is how long
+// after the first member left that was.
+struct gang {
+  int id;                      // Gang id, or 0 if never used
+  int nmembers;                // Processes in it now
+  int ndone;                   // Members that left this round
+  uint first_done;             // Tick the first of them left
+  int skew;                    // Last complete round's skew (-1 if none)
+};
+
+// A scheduling policy for ordinary user processes, consulted
+// once kernel threads, priority-inheritance boosts and the
+// real-time class have had their turn. enqueue, dequeue and
+// on_advice may be 0 if the policy has no use for them.
+struct schedpolicy {
+  char *name;
+  int slice;                           // default quantum, in ticks
+  void (*enqueue)(struct proc *p);     // p became RUNNABLE; p->lock held
+  void (*dequeue)(struct proc *p);     // p is about to run; p->lock held
+  struct proc *(*pick_next)(int id);   // a RUNNABLE process allowed on
+                                       // CPU id, returned locked, or 0
+  int (*tick)(struct proc *p);         // timer tick while p runs;
+                                       // nonzero means yield now
+  void (*on_advice)(int pid);          // the LLM advised running pid
+};
+
+// Bits in the <flags> field of SCHED_LOG PROC lines.
+#define SCHED_FLAG_KTHREAD  0x1   // kernel thread, not a user process
+#define SCHED_FLAG_THREAD   0x2   // clone()d thread sharing its leader's memory
+#define SCHED_FLAG_RT       0x4   // in the real-time (EDF) class
+
 // Per-process state
 struct proc {
   struct spinlock lock;
@@ -91,25 +172,63 @@ struct proc {
   int killed;                  // If non-zero, have been killed
   int xstate;                  // Exit status to be returned to parent's wait
   int pid;                     // Process ID
+  int affinity;                // CPUs it may run on (bit i = hart i)
+  int lastcpu;                 // CPU it last ran on, or -1
+  int migrations;              // Times dispatched on a different CPU
+  int rt;                      // In the real-time (EDF) class?
+  uint rt_runtime;             // Reserved ticks per period
+  uint rt_period;              // Reservation period, in ticks
+  uint rt_deadline;            // Relative deadline within each period
+  uint rt_budget;              // Reserved ticks left this period
+  uint rt_dl;                  // Absolute deadline of this period
+  uint rt_next;                // Tick the next period starts
+  int sgid;                    // Scheduling group (index in sgroups[])
+  int advised;                 // Last dispatched on LLM advice?
+  int nice;                    // NICE_MIN..NICE_MAX, inherited by fork()
+  int gang;                    // Gang id (see setgang()), 0 if none;
+                               // inherited by fork() and clone()
+  int timeslice;               // Quantum in ticks, or 0 for the policy's;
+                               // inherited by fork()
+  int slice;                   // Timer ticks left in the current quantum
+  int skip;                    // Round-robin turns left to pass over
+  int pi_boost[NPRIO];         // Held sleeplocks lending each priority
 
   // wait_lock must be held when using this:
-  struct proc *parent;         // Parent process
+  struct proc *parent;         // Parent process (a thread's is its leader)
 
   // these are private to the process, so p->lock need not be held.
   uint64 kstack;               // Virtual address of kernel stack
   uint64 sz;                   // Size of process memory (bytes)
   pagetable_t pagetable;       // User page table
   struct trapframe *trapframe; // data page for trampoline.S
+  uint64 tfva;                 // User address of trapframe
+  struct usyscall *usyscall;   // read-only page shared with user space
+  struct uring *uring;         // batched syscall ring, or 0 (see uring.c)
   struct context context;      // swtch() here to run process
   struct file *ofile[NOFILE];  // Open files
   struct inode *cwd;           // Current directory
+  int kthread;                 // Kernel thread? (see kthread_create)
+  void (*kfn)(void);           // Kernel thread's function
+  struct proc *leader;         // Thread group leader if clone()d, else 0
+  uint64 ctid;                 // User address cleared when the thread exits
+  struct spinlock tglock;      // Leader's: guards the shared page table,
+                               // sz and ofile[] of its thread group
 
   // Scheduling statistics for LLM-advised scheduling.
   // Updated by the scheduler/timer and exported in SCHED_LOG snapshots.
   int cpu_ticks;               // Total ticks this process has run on CPU
   int wait_ticks;              // Ticks spent RUNNABLE but not running
+  int curwait;                 // Ticks RUNNABLE since it last ran
+  int maxwait;                 // Longest such wait so far
   int io_count;                // Count of times the process blocked (e.g., sleep)
   int recent_cpu;              // Short-term CPU usage metric
+  int lockwait_ticks;          // Ticks spent waiting for sleeplocks
+  int inversions;              // Sleeplock waits behind a lower-priority holder
+  int nvcsw;                   // Times it gave up the CPU to sleep or yield()
+  int nivcsw;                  // Times it was preempted (see yield_preempted())
+
+  // System call counts and time, updated only by the process itself.
+  struct sysstat sysstat;
 
   char name[16];               // Process name (debugging)
 };
@@ -0,0 +1,7 @@
+// Policies understood by setschedpolicy(id).
+#define SCHED_RR       0   // fair-share round-robin; advice is ignored
+#define SCHED_ADVISED  1   // run the LLM's advised pid first, else round-robin
+#define NSCHEDPOLICY   2
+
+// Names for the tools, indexed by id.
+#define SCHED_POLICY_NAMES { [SCHED_RR] "rr", [SCHED_ADVISED] "advised" }
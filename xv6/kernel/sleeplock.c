@@ -6,6 +6,7 @@
 #include "param.h"
 #include "memlayout.h"
 #include "spinlock.h"
+#include "sysstat.h"
 #include "proc.h"
 #include "sleeplock.h"
 
@@ -16,17 +17,29 @@ initsleeplock(struct sleeplock *lk, char *name)
   lk->name = name;
   lk->locked = 0;
   lk->pid = 0;
+  lk->donated = 0;
 }
 
 void
 acquiresleep(struct sleeplock *lk)
 {
+  struct proc *p = myproc();
+  uint start;
+
   acquire(&lk->lk);
-  while (lk->locked) {
-    sleep(lk, &lk->lk);
+  if(lk->locked){
+    // While we wait, lend our priority to the holder so it
+    // isn't stuck behind processes less important than us.
+    // The wait is counted apart from io_count.
+    start = ticks;
+    while (lk->locked) {
+      lk->donated = pi_wait(lk->pid, lk->donated);
+      sleep(lk, &lk->lk);
+    }
+    p->lockwait_ticks += ticks - start;
   }
   lk->locked = 1;
-  lk->pid = myproc()->pid;
+  lk->pid = p->pid;
   release(&lk->lk);
 }
 
@@ -34,6 +47,10 @@ void
 releasesleep(struct sleeplock *lk)
 {
   acquire(&lk->lk);
+  // Waiters that lose the race for the lock lend their
+  // priority again, to the new holder.
+  pi_release(lk->donated);
+  lk->donated = 0;
   lk->locked = 0;
   lk->pid = 0;
   wakeup(lk);
@@ -6,5 +6,7 @@ struct sleeplock {
   // For debugging:
   char *name;        // Name of lock.
   int pid;           // Process holding lock
+
+  int donated;       // Priority lent to the holder by waiters, or 0
 };
 
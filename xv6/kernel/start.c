@@ -6,10 +6,17 @@
 
 void main();
 void timerinit();
+void ipiinit();
 
 // entry.S needs one stack per CPU.
 __attribute__ ((aligned (16))) char stack0[4096 * NCPU];
 
+// a scratch area per CPU for ipivec in kernelvec.S.
+uint64 ipiscratch[NCPU][2];
+
+// in kernelvec.S, takes machine-mode software interrupts.
+extern void ipivec();
+
 // entry.S jumps here in machine mode on stack0.
 void
 start()
@@ -30,7 +37,7 @@ start()
   // delegate all interrupts and exceptions to supervisor mode.
   w_medeleg(0xffff);
   w_mideleg(0xffff);
-  w_sie(r_sie() | SIE_SEIE | SIE_STIE);
+  w_sie(r_sie() | SIE_SEIE | SIE_STIE | SIE_SSIE);
 
   // configure Physical Memory Protection to give supervisor mode
   // access to all of physical memory.
@@ -40,6 +47,9 @@ start()
   // ask for clock interrupts.
   timerinit();
 
+  // let other harts interrupt this one.
+  ipiinit();
+
   // keep each CPU's hartid in its tp register, for cpuid().
   int id = r_mhartid();
   w_tp(id);
@@ -64,3 +74,16 @@ timerinit()
   // ask for the very first timer interrupt.
   w_stimecmp(r_time() + 1000000);
 }
+
+// CLINT software interrupts (IPIs, see kick() in proc.c) can't be
+// delegated to supervisor mode, so take them in machine mode at
+// ipivec, which passes them on as supervisor software interrupts.
+void
+ipiinit()
+{
+  int id = r_mhartid();
+
+  w_mscratch((uint64)&ipiscratch[id][0]);
+  w_mtvec((uint64)ipivec);
+  w_mie(r_mie() | MIE_MSIE);
+}
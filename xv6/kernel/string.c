@@ -1,13 +1,42 @@
 #include "types.h"
 
+// The mem*() routines and strlen() work a 64-bit word at a time
+// where they can, four words per loop iteration, with byte loops
+// for the unaligned head and the tail. Copies and compares only
+// go word-wide when both pointers share an alignment, since a
+// misaligned load can trap. user/ links this file too (as
+// user/string.o), so both sides share one implementation.
+
+typedef uint64 __attribute__((may_alias)) word;
+
+#define WORDSZ   sizeof(word)
+#define ALIGNED(p) (((uint64)(p) & (WORDSZ - 1)) == 0)
+#define ONES     0x0101010101010101UL
+#define HIGHS    0x8080808080808080UL
+
 void*
 memset(void *dst, int c, uint n)
 {
-  char *cdst = (char *) dst;
-  int i;
-  for(i = 0; i < n; i++){
-    cdst[i] = c;
+  uchar *d = dst;
+  word w, *wd;
+
+  for(; n > 0 && !ALIGNED(d); n--)
+    *d++ = c;
+  if(n >= WORDSZ){
+    w = (uchar)c * ONES;
+    wd = (word*)d;
+    for(; n >= 4 * WORDSZ; n -= 4 * WORDSZ, wd += 4){
+      wd[0] = w;
+      wd[1] = w;
+      wd[2] = w;
+      wd[3] = w;
+    }
+    for(; n >= WORDSZ; n -= WORDSZ)
+      *wd++ = w;
+    d = (uchar*)wd;
   }
+  while(n-- > 0)
+    *d++ = c;
   return dst;
 }
 
@@ -18,6 +47,14 @@ memcmp(const void *v1, const void *v2, uint n)
 
   s1 = v1;
   s2 = v2;
+  if((((uint64)s1 ^ (uint64)s2) & (WORDSZ - 1)) == 0){
+    for(; n > 0 && !ALIGNED(s1); n--, s1++, s2++)
+      if(*s1 != *s2)
+        return *s1 - *s2;
+    // skip equal words; the byte loop finds the difference.
+    for(; n >= WORDSZ && *(word*)s1 == *(word*)s2; n -= WORDSZ)
+      s1 += WORDSZ, s2 += WORDSZ;
+  }
   while(n-- > 0){
     if(*s1 != *s2)
       return *s1 - *s2;
@@ -32,20 +69,57 @@ memmove(void *dst, const void *src, uint n)
 {
   const char *s;
   char *d;
+  int words;
 
   if(n == 0)
     return dst;
   
   s = src;
   d = dst;
+  words = (((uint64)s ^ (uint64)d) & (WORDSZ - 1)) == 0;
   if(s < d && s + n > d){
     s += n;
     d += n;
+    if(words){
+      for(; n > 0 && !ALIGNED(d); n--)
+        *--d = *--s;
+      for(; n >= 4 * WORDSZ; n -= 4 * WORDSZ){
+        d -= 4 * WORDSZ;
+        s -= 4 * WORDSZ;
+        ((word*)d)[3] = ((word*)s)[3];
+        ((word*)d)[2] = ((word*)s)[2];
+        ((word*)d)[1] = ((word*)s)[1];
+        ((word*)d)[0] = ((word*)s)[0];
+      }
+      for(; n >= WORDSZ; n -= WORDSZ){
+        d -= WORDSZ;
+        s -= WORDSZ;
+        *(word*)d = *(word*)s;
+      }
+    }
     while(n-- > 0)
       *--d = *--s;
-  } else
+  } else {
+    if(words){
+      for(; n > 0 && !ALIGNED(d); n--)
+        *d++ = *s++;
+      for(; n >= 4 * WORDSZ; n -= 4 * WORDSZ){
+        ((word*)d)[0] = ((word*)s)[0];
+        ((word*)d)[1] = ((word*)s)[1];
+        ((word*)d)[2] = ((word*)s)[2];
+        ((word*)d)[3] = ((word*)s)[3];
+        d += 4 * WORDSZ;
+        s += 4 * WORDSZ;
+      }
+      for(; n >= WORDSZ; n -= WORDSZ){
+        *(word*)d = *(word*)s;
+        d += WORDSZ;
+        s += WORDSZ;
+      }
+    }
     while(n-- > 0)
       *d++ = *s++;
+  }
 
   return dst;
 }
@@ -95,13 +169,22 @@ safestrcpy(char *s, const char *t, int n)
   return os;
 }
 
+// Aligned words never cross a page, so reading the whole word
+// that holds the terminating NUL is safe.
 int
 strlen(const char *s)
 {
-  int n;
-
-  for(n = 0; s[n]; n++)
+  const char *p = s;
+  const word *w;
+
+  for(; !ALIGNED(p); p++)
+    if(*p == 0)
+      return p - s;
+  // a word has a zero byte iff this sets that byte's high bit.
+  for(w = (const word*)p; ((*w - ONES) & ~*w & HIGHS) == 0; w++)
+    ;
+  for(p = (const char*)w; *p; p++)
     ;
-  return n;
+  return p - s;
 }
 
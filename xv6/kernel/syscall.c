@@ -3,10 +3,15 @@
 #include "memlayout.h"
 #include "riscv.h"
 #include "spinlock.h"
+#include "sysstat.h"
 #include "proc.h"
 #include "syscall.h"
 #include "defs.h"
 
+// System-wide counterpart of each process's p->sysstat.
+// Updated with atomic adds since every CPU dispatches syscalls.
+struct sysstat sysstat_total;
+
 // Fetch the uint64 at addr from the current process.
 int
 fetchaddr(uint64 addr, uint64 *ip)
@@ -102,6 +107,23 @@ extern uint64 sys_link(void);
 extern uint64 sys_mkdir(void);
 extern uint64 sys_close(void);
 extern uint64 sys_set_llm_advice(void);
+extern uint64 sys_uring_setup(void);
+extern uint64 sys_uring_enter(void);
+extern uint64 sys_getsysstat(void);
+extern uint64 sys_clone(void);
+extern uint64 sys_futex(void);
+extern uint64 sys_setaffinity(void);
+extern uint64 sys_setrealtime(void);
+extern uint64 sys_setschedgroup(void);
+extern uint64 sys_getpriority(void);
+extern uint64 sys_setpriority(void);
+extern uint64 sys_setschedpolicy(void);
+extern uint64 sys_settimeslice(void);
+extern uint64 sys_setgang(void);
+extern uint64 sys_setstarvebound(void);
+extern uint64 sys_yield(void);
+extern uint64 sys_lseek(void);
+extern uint64 sys_pipe2(void);
 
 // An array mapping syscall numbers from syscall.h
 // to the function that handles the system call.
@@ -128,6 +150,23 @@ static uint64 (*syscalls[])(void) = {
 [SYS_mkdir]          = sys_mkdir,
 [SYS_close]          = sys_close,
 [SYS_set_llm_advice] = sys_set_llm_advice,
+[SYS_uring_setup]    = sys_uring_setup,
+[SYS_uring_enter]    = sys_uring_enter,
+[SYS_getsysstat]     = sys_getsysstat,
+[SYS_clone]          = sys_clone,
+[SYS_futex]          = sys_futex,
+[SYS_setaffinity]    = sys_setaffinity,
+[SYS_setrealtime]    = sys_setrealtime,
+[SYS_setschedgroup]  = sys_setschedgroup,
+[SYS_getpriority]    = sys_getpriority,
+[SYS_setpriority]    = sys_setpriority,
+[SYS_setschedpolicy] = sys_setschedpolicy,
+[SYS_settimeslice]   = sys_settimeslice,
+[SYS_setgang]        = sys_setgang,
+[SYS_setstarvebound] = sys_setstarvebound,
+[SYS_yield]          = sys_yield,
+[SYS_lseek]          = sys_lseek,
+[SYS_pipe2]          = sys_pipe2,
 };
 
 void
@@ -138,9 +177,19 @@ syscall(void)
 
   num = (int)p->trapframe->a7;
   if(num > 0 && num < NELEM(syscalls) && syscalls[num]) {
+    // Count the call before dispatching, since exit() doesn't return.
+    uint64 start = r_time();
+    p->sysstat.count[num]++;
+    __sync_fetch_and_add(&sysstat_total.count[num], 1);
+
     // Look up the system call handler and store its return
     // value in a0 for the user-space caller.
     p->trapframe->a0 = syscalls[num]();
+
+    // Time includes any sleeping the call did (e.g. pause, read).
+    uint64 elapsed = r_time() - start;
+    p->sysstat.time[num] += elapsed;
+    __sync_fetch_and_add(&sysstat_total.time[num], elapsed);
   } else {
     printf("%d %s: unknown sys call %d\n",
            p->pid, p->name, num);
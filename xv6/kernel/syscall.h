@@ -21,3 +21,20 @@
 #define SYS_mkdir          20
 #define SYS_close          21
 #define SYS_set_llm_advice 22   // inject external LLM scheduler advice
+#define SYS_uring_setup    23   // map the batched syscall ring
+#define SYS_uring_enter    24   // run queued ring submissions
+#define SYS_getsysstat     25   // per-syscall counts and time (sysstat.h)
+#define SYS_clone          26   // start a thread sharing the address space
+#define SYS_futex          27   // wait on / wake a user int (futex.h)
+#define SYS_setaffinity    28   // restrict a process to a set of CPUs
+#define SYS_setrealtime    29   // EDF reservation (runtime, period, deadline)
+#define SYS_setschedgroup  30   // fair-share group membership and share
+#define SYS_getpriority    31   // read a process's nice value
+#define SYS_setpriority    32   // set a process's nice value
+#define SYS_setschedpolicy 33   // switch the scheduling policy
+#define SYS_settimeslice   34   // per-process or per-policy quantum
+#define SYS_setgang        35   // join or leave a co-scheduled gang
+#define SYS_setstarvebound 36   // starvation guard's wait bound
+#define SYS_yield          37   // give up the CPU
+#define SYS_lseek          38   // move a file's offset
+#define SYS_pipe2          39   // pipe() with flags (O_LINES)
@@ -10,6 +10,7 @@
 #include "param.h"
 #include "stat.h"
 #include "spinlock.h"
+#include "sysstat.h"
 #include "proc.h"
 #include "fs.h"
 #include "sleeplock.h"
@@ -17,7 +18,8 @@
 #include "fcntl.h"
 
 // Fetch the nth word-sized system call argument as a file descriptor
-// and return both the descriptor and the corresponding struct file.
+// and return both the descriptor and the corresponding struct file,
+// with a reference the caller must drop with fileclose().
 static int
 argfd(int n, int *pfd, struct file **pf)
 {
@@ -26,29 +28,32 @@ argfd(int n, int *pfd, struct file **pf)
 
   // argint() is void-returning in this tree.
   argint(n, &fd);
-  if(fd < 0 || fd >= NOFILE || (f = myproc()->ofile[fd]) == 0)
+  if((f = fileget(fd)) == 0)
     return -1;
   if(pfd)
     *pfd = fd;
-  if(pf)
-    *pf = f;
+  *pf = f;
   return 0;
 }
 
 // Allocate a file descriptor for the given file.
 // Takes over file reference from caller on success.
+// Threads share their leader's table, hence the lock.
 static int
 fdalloc(struct file *f)
 {
   int fd;
-  struct proc *p = myproc();
+  struct proc *l = tgleader(myproc());
 
+  acquire(&l->tglock);
   for(fd = 0; fd < NOFILE; fd++){
-    if(p->ofile[fd] == 0){
-      p->ofile[fd] = f;
+    if(l->ofile[fd] == 0){
+      l->ofile[fd] = f;
+      release(&l->tglock);
       return fd;
     }
   }
+  release(&l->tglock);
   return -1;
 }
 
@@ -60,9 +65,11 @@ sys_dup(void)
 
   if(argfd(0, 0, &f) < 0)
     return -1;
-  if((fd = fdalloc(f)) < 0)
+  // the new descriptor takes over argfd()'s reference.
+  if((fd = fdalloc(f)) < 0){
+    fileclose(f);
     return -1;
-  filedup(f);
+  }
   return fd;
 }
 
@@ -88,7 +95,9 @@ sys_read(void)
     }
   }
 
-  return fileread(f, p, n);
+  n = fileread(f, p, n);
+  fileclose(f);
+  return n;
 }
 
 uint64
@@ -103,7 +112,9 @@ sys_write(void)
   if(argfd(0, 0, &f) < 0)
     return -1;
 
-  return filewrite(f, p, n);
+  n = filewrite(f, p, n);
+  fileclose(f);
+  return n;
 }
 
 uint64
@@ -111,10 +122,20 @@ sys_close(void)
 {
   int fd;
   struct file *f;
+  struct proc *l = tgleader(myproc());
 
-  if(argfd(0, &fd, &f) < 0)
+  // no argfd(): take the table's own reference out from
+  // under the lock, so only one of two racing closes wins.
+  argint(0, &fd);
+  if(fd < 0 || fd >= NOFILE)
     return -1;
-  myproc()->ofile[fd] = 0;
+  acquire(&l->tglock);
+  if((f = l->ofile[fd]) == 0){
+    release(&l->tglock);
+    return -1;
+  }
+  l->ofile[fd] = 0;
+  release(&l->tglock);
   fileclose(f);
   return 0;
 }
@@ -124,11 +145,29 @@ sys_fstat(void)
 {
   struct file *f;
   uint64 st; // user pointer to struct stat
+  int r;
 
   argaddr(1, &st);
   if(argfd(0, 0, &f) < 0)
     return -1;
-  return filestat(f, st);
+  r = filestat(f, st);
+  fileclose(f);
+  return r;
+}
+
+uint64
+sys_lseek(void)
+{
+  struct file *f;
+  int off, whence, r;
+
+  argint(1, &off);
+  argint(2, &whence);
+  if(argfd(0, 0, &f) < 0)
+    return -1;
+  r = fileseek(f, off, whence);
+  fileclose(f);
+  return r;
 }
 
 // Create the path new as a link to the same inode as old.
@@ -486,32 +525,54 @@ sys_exec(void)
   return -1;
 }
 
-uint64
-sys_pipe(void)
+// Make a pipe with pipealloc()'s flags and store its read and
+// write descriptors in the user array at fdarray.
+static int
+pipefds(uint64 fdarray, int flags)
 {
-  uint64 fdarray; // user pointer to array of two integers
   struct file *rf, *wf;
   int fd0, fd1;
   struct proc *p = myproc();
 
-  argaddr(0, &fdarray);
-  if(pipealloc(&rf, &wf) < 0)
+  if(pipealloc(&rf, &wf, flags) < 0)
     return -1;
   fd0 = -1;
   if((fd0 = fdalloc(rf)) < 0 || (fd1 = fdalloc(wf)) < 0){
     if(fd0 >= 0)
-      p->ofile[fd0] = 0;
+      tgleader(p)->ofile[fd0] = 0;
     fileclose(rf);
     fileclose(wf);
     return -1;
   }
   if(copyout(p->pagetable, fdarray, (char*)&fd0, sizeof(fd0)) < 0 ||
      copyout(p->pagetable, fdarray + sizeof(fd0), (char *)&fd1, sizeof(fd1)) < 0){
-    p->ofile[fd0] = 0;
-    p->ofile[fd1] = 0;
+    tgleader(p)->ofile[fd0] = 0;
+    tgleader(p)->ofile[fd1] = 0;
     fileclose(rf);
     fileclose(wf);
     return -1;
   }
   return 0;
 }
+
+uint64
+sys_pipe(void)
+{
+  uint64 fdarray; // user pointer to array of two integers
+
+  argaddr(0, &fdarray);
+  return pipefds(fdarray, 0);
+}
+
+uint64
+sys_pipe2(void)
+{
+  uint64 fdarray;
+  int flags;
+
+  argaddr(0, &fdarray);
+  argint(1, &flags);
+  if(flags & ~O_LINES)
+    return -1;
+  return pipefds(fdarray, flags);
+}
@@ -4,16 +4,10 @@
 #include "param.h"
 #include "memlayout.h"
 #include "spinlock.h"
+#include "sysstat.h"
 #include "proc.h"
 #include "vm.h"
 
-// LLM advice state lives in the scheduler (proc.c).
-// This syscall only updates that shared state.
-extern struct spinlock llm_lock;
-extern int  llm_recommended_pid;
-extern int  llm_advice_valid;
-extern uint llm_advice_timestamp;
-
 uint64
 sys_exit(void)
 {
@@ -54,58 +48,25 @@ sys_wait(void)
 uint64
 sys_sbrk(void)
 {
-  uint64 addr;
   int t;
   int n;
 
   argint(0, &n);
   argint(1, &t);
-  addr = myproc()->sz;
-
-  if(t == SBRK_EAGER || n < 0) {
-    if(growproc(n) < 0) {
-      return -1;
-    }
-  } else {
-    // Lazily allocate memory for this process: increase its memory
-    // size but don't allocate memory. If the process uses the
-    // memory, vmfault() will allocate it.
-    if(addr + n < addr)
-      return -1;
-    if(addr + n > TRAPFRAME)
-      return -1;
-    myproc()->sz += n;
-  }
-  return addr;
+
+  // Unless asked to be eager, allocate memory lazily: increase
+  // the process's size but don't allocate memory. If the
+  // process uses the memory, vmfault() will allocate it.
+  return growproc(n, t != SBRK_EAGER && n > 0);
 }
 
 uint64
 sys_pause(void)
 {
   int n;
-  uint ticks0;
-  struct proc *p = myproc();
-
-  // Count pause as an I/O-style blocking event so the scheduler
-  // can treat it like a simple sleep-like syscall.
-  if(p != 0) {
-    p->io_count++;
-  }
 
   argint(0, &n);
-  if(n < 0)
-    n = 0;
-  acquire(&tickslock);
-  ticks0 = ticks;
-  while(ticks - ticks0 < (uint)n){
-    if(killed(myproc())){
-      release(&tickslock);
-      return -1;
-    }
-    sleep(&ticks, &tickslock);
-  }
-  release(&tickslock);
-  return 0;
+  return kpause(n);
 }
 
 uint64
@@ -133,9 +94,8 @@ sys_uptime(void)
 // Inject LLM scheduling advice into the kernel.
 //
 // User space (llmhelper) calls set_llm_advice(pid),
-// which is wired to this syscall. The scheduler reads
-// llm_recommended_pid / llm_advice_valid under llm_lock
-// and will try to run that PID next, subject to sanity checks.
+// which is wired to this syscall. The advice state itself
+// lives with the scheduler in proc.c.
 uint64
 sys_set_llm_advice(void)
 {
@@ -144,15 +104,154 @@ sys_set_llm_advice(void)
   // argint() has void return type in this tree; it writes into pid.
   argint(0, &pid);
 
-  // Simple sanity check; the scheduler will do the final validation.
-  if(pid <= 0)
-    return -1;
+  return set_llm_advice(pid);
+}
+
+// Copy per-syscall counts and time for a process (or for
+// the whole system, if pid is 0) into a user struct sysstat.
+uint64
+sys_getsysstat(void)
+{
+  int pid;
+  uint64 addr;
 
-  acquire(&llm_lock);
-  llm_recommended_pid  = pid;
-  llm_advice_valid     = 1;
-  llm_advice_timestamp = ticks;
-  release(&llm_lock);
+  argint(0, &pid);
+  argaddr(1, &addr);
+  return procsysstat(pid, addr);
+}
 
+// Start a thread running fn(arg) on the user stack whose top
+// is stack; see kclone().
+uint64
+sys_clone(void)
+{
+  uint64 fn, arg, stack, ctid;
+
+  argaddr(0, &fn);
+  argaddr(1, &arg);
+  argaddr(2, &stack);
+  argaddr(3, &ctid);
+  return kclone(fn, arg, stack, ctid);
+}
+
+// FUTEX_WAIT or FUTEX_WAKE on a user int; see kfutex().
+uint64
+sys_futex(void)
+{
+  uint64 addr;
+  int op, val;
+
+  argaddr(0, &addr);
+  argint(1, &op);
+  argint(2, &val);
+  return kfutex(addr, op, val);
+}
+
+// Set a process's CPU affinity mask; see setaffinity().
+uint64
+sys_setaffinity(void)
+{
+  int pid, mask;
+
+  argint(0, &pid);
+  argint(1, &mask);
+  return setaffinity(pid, mask);
+}
+
+// Enter or leave the real-time class; see setrealtime().
+uint64
+sys_setrealtime(void)
+{
+  int pid, runtime, period, deadline;
+
+  argint(0, &pid);
+  argint(1, &runtime);
+  argint(2, &period);
+  argint(3, &deadline);
+  return setrealtime(pid, runtime, period, deadline);
+}
+
+// Join a scheduling group and/or set its share; see setschedgroup().
+uint64
+sys_setschedgroup(void)
+{
+  int pid, gid, share;
+
+  argint(0, &pid);
+  argint(1, &gid);
+  argint(2, &share);
+  return setschedgroup(pid, gid, share);
+}
+
+// Read a process's nice value; see getpriority().
+uint64
+sys_getpriority(void)
+{
+  int pid;
+  uint64 addr;
+
+  argint(0, &pid);
+  argaddr(1, &addr);
+  return getpriority(pid, addr);
+}
+
+// Set a process's nice value; see setpriority().
+uint64
+sys_setpriority(void)
+{
+  int pid, nice;
+
+  argint(0, &pid);
+  argint(1, &nice);
+  return setpriority(pid, nice);
+}
+
+// Switch the scheduling policy; see setschedpolicy().
+uint64
+sys_setschedpolicy(void)
+{
+  int id;
+
+  argint(0, &id);
+  return setschedpolicy(id);
+}
+
+// Set a process's or the policy's time slice; see settimeslice().
+uint64
+sys_settimeslice(void)
+{
+  int pid, ticks;
+
+  argint(0, &pid);
+  argint(1, &ticks);
+  return settimeslice(pid, ticks);
+}
+
+// Join or leave a gang; see setgang().
+uint64
+sys_setgang(void)
+{
+  int pid, id;
+
+  argint(0, &pid);
+  argint(1, &id);
+  return setgang(pid, id);
+}
+
+// Set the starvation guard's bound; see setstarvebound().
+uint64
+sys_setstarvebound(void)
+{
+  int ticks;
+
+  argint(0, &ticks);
+  return setstarvebound(ticks);
+}
+
+// Give up the CPU for one scheduling round.
+uint64
+sys_yield(void)
+{
+  yield();
   return 0;
 }
@@ -0,0 +1,12 @@
+// Per-system-call accounting, kept per process (struct proc)
+// and system-wide (syscall.c), and returned by getsysstat().
+// The log counters are kept by log.c's commit().
+
+#define NSYSCALL 64   // table size; must exceed every SYS_ number
+
+struct sysstat {
+  uint64 count[NSYSCALL];   // calls made, indexed by SYS_ number
+  uint64 time[NSYSCALL];    // cumulative r_time() units from entry to return
+  uint64 logcommits;        // log transactions committed (system-wide only)
+  uint64 logblocks;         // blocks those transactions wrote (system-wide only)
+};
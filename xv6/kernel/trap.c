@@ -3,6 +3,7 @@
 #include "memlayout.h"
 #include "riscv.h"
 #include "spinlock.h"
+#include "sysstat.h"
 #include "proc.h"
 #include "defs.h"
 
@@ -32,6 +33,9 @@ void
 trapinithart(void)
 {
   w_stvec((uint64)kernelvec);
+
+  // let user programs read the time CSR, for rdtime() in ulib.c.
+  w_scounteren(r_scounteren() | 2);
 }
 
 //
@@ -85,9 +89,10 @@ usertrap(void)
   if(killed(p))
     kexit(-1);
 
-  // give up the CPU if this is a timer interrupt.
-  if(which_dev == 2)
-    yield();
+  // give up the CPU if this is a timer interrupt and the
+  // scheduling policy says so, or if kick() asked.
+  if((which_dev == 2 && schedtick(p)) || which_dev == 3)
+    yield_preempted();
 
   prepare_return();
 
@@ -122,6 +127,10 @@ prepare_return(void)
   p->trapframe->kernel_trap = (uint64)usertrap;
   p->trapframe->kernel_hartid = r_tp();         // hartid for cpuid()
 
+  // tell uservec and userret where this thread's trapframe
+  // is mapped in the user page table.
+  w_sscratch(p->tfva);
+
   // set up the registers that trampoline.S's sret will use
   // to get to user space.
 
@@ -156,11 +165,12 @@ kerneltrap(void)
     panic("kerneltrap");
   }
 
-  // give up the CPU if this is a timer interrupt.
-  if(which_dev == 2 && myproc() != 0)
-    yield();
+  // give up the CPU if this is a timer interrupt and the
+  // scheduling policy says so, or if kick() asked.
+  if(myproc() != 0 && ((which_dev == 2 && schedtick(myproc())) || which_dev == 3))
+    yield_preempted();
 
-  // the yield() may have caused some traps to occur,
+  // the yield_preempted() may have caused some traps to occur,
   // so restore trap registers for use by kernelvec.S's sepc instruction.
   w_sepc(sepc);
   w_sstatus(sstatus);
@@ -174,17 +184,14 @@ clockintr(void)
     acquire(&tickslock);
     ticks++;
     wakeup(&ticks);
+    // Periodically have schedlogd log a snapshot of scheduler
+    // state for the external agent.
+    if(ticks % LOG_INTERVAL == 0)
+      schedlog_request();
     release(&tickslock);
 
     // Update per-process scheduling statistics on each tick.
     update_sched_stats();
-
-    // Periodically log a snapshot of scheduler state for the external agent.
-    static uint log_counter = 0;
-    log_counter++;
-    if(log_counter % LOG_INTERVAL == 0){
-      log_scheduling_state();
-    }
   }
 
   // ask for the next timer interrupt. this also clears
@@ -196,6 +203,7 @@ clockintr(void)
 // check if it's an external interrupt or software interrupt,
 // and handle it.
 // returns 2 if timer interrupt,
+// 3 if kick()ed to reschedule,
 // 1 if other device,
 // 0 if not recognized.
 int
@@ -228,6 +236,10 @@ devintr(void)
     // timer interrupt.
     clockintr();
     return 2;
+  } else if(scause == 0x8000000000000001L){
+    // software interrupt: kick() wants this CPU to reschedule.
+    w_sip(r_sip() & ~2);
+    return 3;
   } else {
     return 0;
   }
@@ -7,6 +7,7 @@
 #include "memlayout.h"
 #include "riscv.h"
 #include "spinlock.h"
+#include "sysstat.h"
 #include "proc.h"
 #include "defs.h"
 
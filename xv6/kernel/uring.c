@@ -0,0 +1,125 @@
+//
+// Batched system call ring.
+// A process maps one shared page with uring_setup() and then
+// submits many read/write/pause/advice operations per trap
+// with uring_enter(). See uring.h for the ring layout.
+//
+
+#include "types.h"
+#include "riscv.h"
+#include "defs.h"
+#include "param.h"
+#include "memlayout.h"
+#include "spinlock.h"
+#include "sysstat.h"
+#include "proc.h"
+#include "fs.h"
+#include "sleeplock.h"
+#include "file.h"
+#include "uring.h"
+
+// Run one submission and return what the
+// equivalent system call would have returned.
+static int
+uring_run(struct uring_sqe *sqe)
+{
+  struct file *f;
+  int r;
+
+  switch(sqe->op){
+  case URING_OP_NOP:
+    return 0;
+  case URING_OP_READ:
+  case URING_OP_WRITE:
+    if((f = fileget(sqe->fd)) == 0)
+      return -1;
+    if(sqe->op == URING_OP_READ)
+      r = fileread(f, sqe->addr, sqe->len);
+    else
+      r = filewrite(f, sqe->addr, sqe->len);
+    fileclose(f);
+    return r;
+  case URING_OP_PAUSE:
+    return kpause(sqe->len);
+  case URING_OP_SET_LLM_ADVICE:
+    return set_llm_advice(sqe->len);
+  }
+  return -1;
+}
+
+// Map this process's ring at URING, allocating it on first use.
+// Returns URING, or -1 if out of memory or called from a
+// clone()d thread. The ring is not inherited by fork() children.
+uint64
+sys_uring_setup(void)
+{
+  struct proc *p = myproc();
+  struct uring *r;
+
+  if(sizeof(struct uring) > PGSIZE)
+    panic("uring_setup: ring too big");
+
+  if(p->uring)
+    return URING;
+
+  // URING belongs to the leader of a shared page table.
+  if(p->leader)
+    return -1;
+
+  if((r = (struct uring *)kalloc()) == 0)
+    return -1;
+  memset(r, 0, PGSIZE);
+  if(mappages(p->pagetable, URING, PGSIZE, (uint64)r, PTE_R | PTE_W | PTE_U) < 0){
+    kfree((void*)r);
+    return -1;
+  }
+  p->uring = r;
+  return URING;
+}
+
+// Run up to n queued submissions, in order, posting one
+// completion for each. Stops early if the submission queue
+// is empty, the completion queue is full, or the process
+// is killed. Returns the number of submissions consumed.
+uint64
+sys_uring_enter(void)
+{
+  struct proc *p = myproc();
+  struct uring *r = p->uring;
+  struct uring_sqe sqe;
+  struct uring_cqe *cqe;
+  uint head;
+  int n, done;
+
+  argint(0, &n);
+  if(r == 0)
+    return -1;
+
+  for(done = 0; done < n; done++){
+    head = r->sq_head;
+    if(head == r->sq_tail)
+      break;
+    if(r->cq_tail - r->cq_head >= URING_ENTRIES)
+      break;
+
+    // make sure we see the entry written before sq_tail moved,
+    // and copy it so user space can't change it mid-operation.
+    __sync_synchronize();
+    sqe = r->sq[head % URING_ENTRIES];
+
+    int res = uring_run(&sqe);
+
+    cqe = &r->cq[r->cq_tail % URING_ENTRIES];
+    cqe->user_data = sqe.user_data;
+    cqe->res = res;
+    __sync_synchronize();
+    r->cq_tail++;
+    r->sq_head = head + 1;
+
+    if(killed(p)){
+      done++;
+      break;
+    }
+  }
+  return done;
+}
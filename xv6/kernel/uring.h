@@ -0,0 +1,40 @@
+// Batched system call ring, shared between one process and
+// the kernel in a single page mapped at URING (memlayout.h).
+//
+// User space fills sq[] entries and advances sq_tail, then
+// calls uring_enter(n). The kernel runs up to n queued entries
+// in order, advancing sq_head, and posts one cq[] entry per
+// submission, advancing cq_tail. User space consumes
+// completions by advancing cq_head. Indices grow without
+// bound and are taken modulo URING_ENTRIES.
+
+#define URING_ENTRIES  64   // must be a power of two
+
+// Operations understood by uring_enter().
+#define URING_OP_NOP            0
+#define URING_OP_READ           1   // read(fd, addr, len)
+#define URING_OP_WRITE          2   // write(fd, addr, len)
+#define URING_OP_PAUSE          3   // pause(len)
+#define URING_OP_SET_LLM_ADVICE 4   // set_llm_advice(len)
+
+struct uring_sqe {
+  int op;           // URING_OP_*
+  int fd;           // file descriptor for READ/WRITE
+  uint64 addr;      // user buffer for READ/WRITE
+  int len;          // byte count, ticks, or pid, depending on op
+  int user_data;    // copied unchanged into the completion
+};
+
+struct uring_cqe {
+  int user_data;    // from the matching submission
+  int res;          // what the equivalent system call would return
+};
+
+struct uring {
+  uint sq_head;     // next entry the kernel will consume
+  uint sq_tail;     // next entry user space will fill
+  uint cq_head;     // next completion user space will consume
+  uint cq_tail;     // next completion the kernel will fill
+  struct uring_sqe sq[URING_ENTRIES];
+  struct uring_cqe cq[URING_ENTRIES];
+};
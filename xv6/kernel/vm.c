@@ -5,6 +5,7 @@
 #include "riscv.h"
 #include "defs.h"
 #include "spinlock.h"
+#include "sysstat.h"
 #include "proc.h"
 #include "fs.h"
 
@@ -35,6 +36,9 @@ kvmmake(void)
   // PLIC
   kvmmap(kpgtbl, PLIC, PLIC, 0x4000000, PTE_R | PTE_W);
 
+  // CLINT, for kick()'s inter-processor interrupts
+  kvmmap(kpgtbl, CLINT, CLINT, 0x10000, PTE_R | PTE_W);
+
   // map kernel text executable and read-only.
   kvmmap(kpgtbl, KERNBASE, KERNBASE, (uint64)etext-KERNBASE, PTE_R | PTE_X);
 
@@ -449,26 +453,31 @@ copyinstr(pagetable_t pagetable, char *dst, uint64 srcva, uint64 max)
 // that was lazily allocated in sys_sbrk().
 // returns 0 if va is invalid or already mapped, or if
 // out of physical memory, and physical address if successful.
+// threads sharing the page table may fault on the same page
+// at once, so this holds the thread group's tglock.
 uint64
 vmfault(pagetable_t pagetable, uint64 va, int read)
 {
-  uint64 mem;
+  uint64 mem = 0;
   struct proc *p = myproc();
+  struct proc *l = tgleader(p);
 
   if (va >= p->sz)
     return 0;
   va = PGROUNDDOWN(va);
-  if(ismapped(pagetable, va)) {
-    return 0;
-  }
+  acquire(&l->tglock);
+  if(ismapped(pagetable, va))
+    goto out;
   mem = (uint64) kalloc();
   if(mem == 0)
-    return 0;
+    goto out;
   memset((void *) mem, 0, PGSIZE);
   if (mappages(p->pagetable, va, PGSIZE, mem, PTE_W|PTE_U|PTE_R) != 0) {
     kfree((void *)mem);
-    return 0;
+    mem = 0;
   }
+out:
+  release(&l->tglock);
   return mem;
 }
 
@@ -5,24 +5,38 @@
 #
 # ./test-xv6.py usertests  (runs usertests)
 # ./test-xv6.py -q usertests (runs the quick tests of usertests)
+# ./test-xv6.py --cpus 4 -p 4 usertests (runs 4 usertests at a time)
 # ./test-xv6.py crash  (runs the crash tests)
 # ./test-xv6.py log (runs the log crash test)
+# ./test-xv6.py perf (runs the benchmarks, compares with perf-baseline.json)
+# ./test-xv6.py --cpus 1 --update-baseline perf (records a new baseline)
 
-import argparse, os, inspect, re, signal, subprocess, sys, time
+import argparse, json, os, inspect, re, signal, subprocess, sys, time
 from subprocess import run
 
 parser = argparse.ArgumentParser()
 parser.add_argument('testrex', help="test name or regular expression")
 parser.add_argument("-q", action='store_true', help="usertests quick")
+parser.add_argument("-p", type=int, metavar="N",
+                    help="usertests: run up to N tests at a time")
+parser.add_argument("--cpus", type=int, help="harts to boot (make's CPUS)")
+parser.add_argument("--baseline", default="perf-baseline.json",
+                    help="perf baseline file")
+parser.add_argument("--update-baseline", action='store_true',
+                    help="perf: store this run as the baseline")
+parser.add_argument("--tolerance", type=float,
+                    help="perf: default tolerance band, as a fraction")
 args = parser.parse_args()
 
 class QEMU(object):
 
-    def __init__(self, reset=False):
+    def __init__(self, reset=False, cpus=None):
         if reset:
             self.build_xv6()
             self.reset_fs()
         q = ["make", "qemu"]
+        if cpus:
+            q.append("CPUS=%d" % cpus)
         self.proc = subprocess.Popen(q, stdin=subprocess.PIPE,
                                       stdout=subprocess.PIPE,
                                       stderr=subprocess.STDOUT)
@@ -194,11 +208,143 @@ def test_usertests(test=""):
         timeout = 300
     elif test != "":
         opt += " " + test
-    q = QEMU(True)
+    if args.p:
+        opt = " -p %d%s" % (args.p, opt)
+    q = QEMU(True, args.cpus)
     q.cmd("usertests" + opt + "\n")
     q.monitor('^ALL TESTS PASSED', progress='test', timeout=timeout)
     q.stop()
 
+# The in-guest benchmarks perf runs, in order. Each prints
+# "RESULT bench=<b> key=value ..." lines.
+PERF_BENCHES = [
+    "microbench -r 100",
+    "fsbench -s 32",
+    "schedbench -u 10",
+    "mallocbench",
+    "membench",
+]
+
+# Fields that name a result rather than measure it.
+PERF_ID = ("bench", "test", "impl", "bs", "size")
+
+# Tolerance bands, as a fraction of the baseline, by metric name
+# suffix; the longest matching suffix wins. A baseline file can
+# override these with its own "tolerance" table, and --tolerance
+# the default. Tails and maxima are noisier than medians under qemu.
+PERF_TOLERANCE = {
+    "": 0.25,
+    "p99_ns": 0.50,
+    "_max_us": 0.50,
+}
+
+# The kernel's periodic SCHED_LOG lines go to the same console and
+# can land in the middle of a benchmark's line.
+KERNEL_LINE = re.compile(r'(SCHED_LOG_START|SCHED_LOG_END|'
+                         r'(TIMESTAMP|POLICY|PREEMPT|STARVE|PROC|GROUP|GANG):[^\n]*)\r?\n')
+
+def perf_direction(metric):
+    """+1 if bigger is better, -1 if smaller is, 0 if not compared."""
+    if metric == "commits_per_s":
+        return 0            # depends on the workload, not its speed
+    if metric.endswith("_per_s"):
+        return 1
+    if metric.endswith("_ns") or metric.endswith("_us"):
+        return -1
+    return 0
+
+def perf_parse(output):
+    """Map "bench/test/impl=i/bs=n/size=n" (those present) to {metric: value} for each RESULT line."""
+    results = {}
+    for line in KERNEL_LINE.sub("", output).splitlines():
+        line = line.strip()
+        if not line.startswith("RESULT "):
+            continue
+        try:
+            fields = dict(kv.split("=", 1) for kv in line.split()[1:])
+            key = "/".join(fields[k] if k in ("bench", "test") else
+                           "%s=%s" % (k, fields[k])
+                           for k in PERF_ID if k in fields)
+            metrics = {m: float(v) for m, v in fields.items()
+                       if perf_direction(m)}
+        except ValueError:
+            print("perf: garbled line:", line)
+            continue
+        results[key] = metrics
+    return results
+
+def perf_tolerance(metric, bands):
+    best = max((s for s in bands if metric.endswith(s)), key=len)
+    return bands[best]
+
+def perf_compare(base, cur, bands):
+    """Print each metric against the baseline; return the regressions."""
+    bad = []
+    for key in sorted(base):
+        for metric, want in sorted(base[key].items()):
+            got = cur.get(key, {}).get(metric)
+            name = "%s %s" % (key, metric)
+            if got is None:
+                print("MISSING  %s" % name)
+                bad.append(name)
+                continue
+            tol = perf_tolerance(metric, bands)
+            change = (got - want) / want if want else 0.0
+            if perf_direction(metric) * change < -tol:
+                verdict = "REGRESS"
+                bad.append(name)
+            elif perf_direction(metric) * change > tol:
+                verdict = "better"
+            else:
+                verdict = "ok"
+            print("%-8s %s: %g (baseline %g, %+.0f%%, band %.0f%%)" %
+                  (verdict, name, got, want, change * 100, tol * 100))
+    for key in sorted(set(cur) - set(base)):
+        print("new      %s (not in baseline)" % key)
+    return bad
+
+def test_perf():
+    cpus = args.cpus or 3
+    print("Run benchmarks on %d CPUs" % cpus)
+    q = QEMU(True, cpus)
+    # one command per line: sh's line buffer is only 100 bytes.
+    q.cmd("".join(c + "\n" for c in PERF_BENCHES + ["echo PERF DONE"]))
+    q.monitor('^PERF DONE', progress='^RESULT', timeout=900)
+    q.stop()
+    with open("test-xv6.out", "w") as f:
+        f.write(q.output)
+    cur = perf_parse(q.output)
+    if not cur:
+        print("FAIL: no RESULT lines; see test-xv6.out")
+        sys.exit(1)
+
+    try:
+        with open(args.baseline) as f:
+            baseline = json.load(f)
+    except FileNotFoundError:
+        baseline = {}
+    bands = dict(PERF_TOLERANCE)
+    bands.update(baseline.get("tolerance", {}))
+    if args.tolerance is not None:
+        bands[""] = args.tolerance
+    runs = baseline.setdefault("cpus", {})
+
+    if args.update_baseline or str(cpus) not in runs:
+        runs[str(cpus)] = cur
+        baseline.setdefault("tolerance", PERF_TOLERANCE)
+        with open(args.baseline, "w") as f:
+            json.dump(baseline, f, indent=2, sort_keys=True)
+            f.write("\n")
+        print("Recorded %d results as the %d-CPU baseline in %s" %
+              (len(cur), cpus, args.baseline))
+        return
+
+    bad = perf_compare(runs[str(cpus)], cur, bands)
+    if bad:
+        print("FAIL: %d regression(s)" % len(bad))
+        sys.exit(1)
+    print("OK")
+
 def main():
     print(args)
     rex = r'%s' % args.testrex
@@ -9,7 +9,7 @@
 //     to pick other PIDs.
 //
 // Usage:
-//   cpubound [total_iters] [workers] [chunks] [sleep_ticks]
+//   cpubound [total_iters] [workers] [chunks] [sleep_ticks] [gang]
 //
 //   total_iters   - total iterations across *all* workers
 //   workers       - number of worker processes (parent + children)
@@ -17,6 +17,11 @@
 //                   (0 or 1 => single big chunk, no extra pauses)
 //   sleep_ticks   - if >0 and chunks>1, call pause(sleep_ticks)
 //                   between chunks
+//   gang          - if 1, put the workers in one gang (see setgang())
+//                   so the harts run them side by side
+//
+// When all workers are done the parent prints the completion skew:
+// ticks between the first and the last worker finishing.
 //
 // Examples:
 //   cpubound
@@ -42,6 +47,7 @@ main(int argc, char *argv[])
   int workers     = 4;          // parent + children (total worker procs)
   int chunks      = 1;          // per-worker chunks (1 => no extra chunking)
   int sleep_ticks = 0;          // pause() between chunks if >0 and chunks>1
+  int gang        = 0;          // gang-schedule the workers?
 
   if(argc >= 2){
     int v = atoi(argv[1]);
@@ -63,6 +69,8 @@ main(int argc, char *argv[])
     if(v > 0)
       sleep_ticks = v;
   }
+  if(argc >= 6)
+    gang = atoi(argv[5]) != 0;
 
   // Clamp workers to a sane range.
   if(workers < 1)
@@ -87,9 +95,13 @@ main(int argc, char *argv[])
   int parent_pid = getpid();
 
   printf("cpubound: parent pid=%d, workers=%d, total_iters=%d, "
-         "per_worker=%d, chunks=%d, chunk_iters=%d, sleep=%d\n",
+         "per_worker=%d, chunks=%d, chunk_iters=%d, sleep=%d, gang=%d\n",
          parent_pid, workers, total_iters,
-         local_iters, chunks, chunk_iters, sleep_ticks);
+         local_iters, chunks, chunk_iters, sleep_ticks, gang);
+
+  // The children inherit the gang; the parent's pid names it.
+  if(gang && setgang(0, parent_pid) < 0)
+    printf("cpubound: setgang failed, running ungrouped\n");
 
   // Fork workers-1 children; each child breaks out and runs its own loop.
   for(int i = 0; i < workers - 1; i++){
@@ -134,17 +146,29 @@ main(int argc, char *argv[])
     }
   }
 
+  int finished = uptime();
+  if(gang)
+    setgang(0, 0);
+
   printf("cpubound(pid=%d): finished (acc=%d)\n",
          mypid, acc & 0x7fffffff);
 
   // Only the original parent waits for children, to avoid zombies.
+  // Children report the tick they finished as their exit status.
   if(mypid == parent_pid){
-    int w;
-    while((w = wait(0)) > 0){
+    int w, status;
+    int first = finished, last = finished;
+    while((w = wait(&status)) > 0){
       printf("cpubound: child %d exited\n", w);
+      if(status < first)
+        first = status;
+      if(status > last)
+        last = status;
     }
-    printf("cpubound(pid=%d): all children finished\n", parent_pid);
+    printf("cpubound(pid=%d): all children finished, completion skew=%d ticks\n",
+           parent_pid, last - first);
+    exit(0);
   }
 
-  exit(0);
+  exit(finished);
 }
@@ -0,0 +1,356 @@
+// user/fsbench.c
+// File system throughput benchmark. Where stressfs and logstress
+// check that concurrent writes work, fsbench measures how fast
+// they go, so buffer cache, log and virtio changes can be
+// compared by number. One machine-readable line per test:
+//
+//   RESULT bench=fsbench label=<l> test=<t> bs=<b> ops=<n> bytes=<n>
+//     elapsed_us=<t> mb_per_s=<x.xx> ops_per_s=<r> commits=<c> commits_per_s=<r>
+//
+// (all on one line). An op is one read() or write() of bs bytes,
+// or one create, unlink or open() for the small-file and lookup
+// tests, which have bs=0. commits counts log transactions
+// committed while the test ran, from getsysstat().
+//
+// Usage:
+//   fsbench [-s kbytes] [-b bs] [-n files] [-d depth] [-w writers] [-l label] [test ...]
+//
+//   -s kbytes   size of the file the read/write tests use (default 64)
+//   -b bs       only this block size (default 512, 1024 and 4096)
+//   -n files    small files to create and delete (default 100)
+//   -d depth    directories deep the lookup test opens (default 8)
+//   -w writers  processes in the concurrent test (default 4)
+//   -l label    tag copied into the RESULT lines (default "-")
+//
+// Tests (default: all of them):
+//   seqwrite    write the file from start to end
+//   seqread     read it back from start to end
+//   randwrite   overwrite one block at a time at random offsets
+//   randread    read one block at a time at random offsets
+//   create      create the small files, 100 bytes each
+//   delete      unlink them again
+//   lookup      open() a file depth directories down
+//   concurrent  writers processes each write kbytes/writers to their
+//               own file at once (block size bs, or 1024)
+
+#include "kernel/types.h"
+#include "kernel/stat.h"
+#include "kernel/fcntl.h"
+#include "kernel/fs.h"
+#include "kernel/param.h"
+#include "kernel/sysstat.h"
+#include "user/user.h"
+
+#define MAXBS 4096
+#define MAXWRITERS 8
+#define MAXDEPTH 40               // "dN/" per level must fit MAXPATH
+#define MAXKB ((int)(MAXFILE * BSIZE / 1024))
+
+static char buf[MAXBS];
+static struct sysstat st;
+static char *label = "-";
+static uint64 t0, c0;
+static uint rnd = 1;
+
+// Start timing a test.
+static void
+start(void)
+{
+  getsysstat(0, &st);
+  c0 = st.logcommits;
+  t0 = rdtime();
+}
+
+static uint64
+rate(uint64 n, uint64 t)
+{
+  return t ? n * TIMEBASE_HZ / t : 0;
+}
+
+// Stop timing and print the RESULT line for test.
+static void
+stop(char *test, int bs, int ops)
+{
+  uint64 t = rdtime() - t0;
+  uint64 bytes = (uint64)bs * ops;
+  uint64 mb100 = rate(bytes * 100, t) / (1024 * 1024);
+
+  getsysstat(0, &st);
+  uint64 commits = st.logcommits - c0;
+  printf("RESULT bench=fsbench label=%s test=%s bs=%d ops=%d bytes=%lu "
+         "elapsed_us=%lu mb_per_s=%lu.%s%lu ops_per_s=%lu commits=%lu commits_per_s=%lu\n",
+         label, test, bs, ops, bytes, t / (TIMEBASE_HZ / 1000000),
+         mb100 / 100, mb100 % 100 < 10 ? "0" : "", mb100 % 100,
+         rate(ops, t), commits, rate(commits, t));
+}
+
+static uint
+nextrand(void)
+{
+  rnd = rnd * 1103515245 + 12345;
+  return rnd >> 8;
+}
+
+static int
+want(char *test, int argc, char **argv)
+{
+  if(argc == 0)
+    return 1;
+  for(int i = 0; i < argc; i++)
+    if(strcmp(argv[i], test) == 0)
+      return 1;
+  return 0;
+}
+
+// Write nblocks blocks of bs to fd; 0, or -1 on a short write.
+static int
+fill(int fd, int bs, int nblocks)
+{
+  for(int i = 0; i < nblocks; i++)
+    if(write(fd, buf, bs) != bs)
+      return -1;
+  return 0;
+}
+
+// The read/write tests at one block size, on a file of kbytes.
+static void
+rw(int bs, int kbytes, int argc, char **argv)
+{
+  char *name = "fsb.rw";
+  int nblocks = kbytes * 1024 / bs;
+  int fd, i;
+
+  memset(buf, 'f', bs);
+  if((fd = open(name, O_CREATE | O_TRUNC | O_RDWR)) < 0){
+    fprintf(2, "fsbench: cannot create %s\n", name);
+    return;
+  }
+  start();
+  if(fill(fd, bs, nblocks) < 0){
+    fprintf(2, "fsbench: write %s failed; file system full?\n", name);
+    close(fd);
+    unlink(name);
+    return;
+  }
+  if(want("seqwrite", argc, argv))
+    stop("seqwrite", bs, nblocks);
+
+  if(want("seqread", argc, argv)){
+    lseek(fd, 0, SEEK_SET);
+    start();
+    for(i = 0; i < nblocks; i++)
+      if(read(fd, buf, bs) != bs)
+        break;
+    stop("seqread", bs, i);
+  }
+
+  if(want("randwrite", argc, argv)){
+    start();
+    for(i = 0; i < nblocks; i++){
+      lseek(fd, (nextrand() % nblocks) * bs, SEEK_SET);
+      if(write(fd, buf, bs) != bs)
+        break;
+    }
+    stop("randwrite", bs, i);
+  }
+
+  if(want("randread", argc, argv)){
+    start();
+    for(i = 0; i < nblocks; i++){
+      lseek(fd, (nextrand() % nblocks) * bs, SEEK_SET);
+      if(read(fd, buf, bs) != bs)
+        break;
+    }
+    stop("randread", bs, i);
+  }
+
+  close(fd);
+  unlink(name);
+}
+
+static void
+smallname(char *name, int i)
+{
+  name[0] = 's';
+  name[1] = '0' + i / 100 % 10;
+  name[2] = '0' + i / 10 % 10;
+  name[3] = '0' + i % 10;
+  name[4] = 0;
+}
+
+// Create nfiles files of 100 bytes in a fresh directory, then
+// unlink them.
+static void
+smallfiles(int nfiles, int argc, char **argv)
+{
+  char name[8];
+  int fd, i;
+
+  if(mkdir("fsb.small") < 0 || chdir("fsb.small") < 0){
+    fprintf(2, "fsbench: cannot make fsb.small\n");
+    return;
+  }
+  memset(buf, 's', 100);
+  start();
+  for(i = 0; i < nfiles; i++){
+    smallname(name, i);
+    if((fd = open(name, O_CREATE | O_WRONLY)) < 0)
+      break;
+    write(fd, buf, 100);
+    close(fd);
+  }
+  if(want("create", argc, argv))
+    stop("create", 0, i);
+  nfiles = i;
+
+  start();
+  for(i = 0; i < nfiles; i++){
+    smallname(name, i);
+    if(unlink(name) < 0)
+      break;
+  }
+  if(want("delete", argc, argv))
+    stop("delete", 0, i);
+
+  chdir("..");
+  unlink("fsb.small");
+}
+
+// Open and close a file depth directories down n times, looking
+// up every path component each time.
+static void
+lookup(int depth, int n)
+{
+  char path[MAXPATH];
+  int fd, i, len = 0;
+
+  for(i = 0; i < depth; i++){
+    path[len++] = 'd';
+    path[len++] = '0' + i % 10;
+    path[len] = 0;
+    if(mkdir(path) < 0){
+      fprintf(2, "fsbench: cannot make %s\n", path);
+      return;
+    }
+    path[len++] = '/';
+  }
+  strcpy(path + len, "f");
+  if((fd = open(path, O_CREATE | O_WRONLY)) < 0){
+    fprintf(2, "fsbench: cannot create %s\n", path);
+    return;
+  }
+  close(fd);
+
+  start();
+  for(i = 0; i < n; i++){
+    if((fd = open(path, O_RDONLY)) < 0)
+      break;
+    close(fd);
+  }
+  stop("lookup", 0, i);
+
+  // take the tree down from the bottom.
+  unlink(path);
+  while(len > 0){
+    path[--len] = 0;               // drop the trailing '/'
+    unlink(path);
+    len -= 2;
+    path[len] = 0;
+  }
+}
+
+// writers processes each write kbytes/writers in blocks of bs to
+// their own file, all at once, so their transactions share the log.
+static void
+concurrent(int writers, int bs, int kbytes)
+{
+  char name[8] = "fsb.w0";
+  int nblocks = kbytes * 1024 / writers / bs;
+  int i, xstatus, ok = 0;
+
+  memset(buf, 'w', bs);
+  start();
+  for(i = 0; i < writers; i++){
+    name[5] = '0' + i;
+    int pid = fork();
+    if(pid < 0){
+      fprintf(2, "fsbench: fork failed\n");
+      break;
+    }
+    if(pid == 0){
+      int fd = open(name, O_CREATE | O_TRUNC | O_WRONLY);
+      if(fd < 0 || fill(fd, bs, nblocks) < 0)
+        exit(1);
+      exit(0);
+    }
+  }
+  while(wait(&xstatus) > 0)
+    if(xstatus == 0)
+      ok++;
+  stop("concurrent", bs, ok * nblocks);
+  for(i = 0; i < writers; i++){
+    name[5] = '0' + i;
+    unlink(name);
+  }
+}
+
+static void
+usage(void)
+{
+  fprintf(2, "usage: fsbench [-s kbytes] [-b bs] [-n files] [-d depth] [-w writers] [-l label] [test ...]\n");
+  exit(1);
+}
+
+int
+main(int argc, char *argv[])
+{
+  static int sizes[] = { 512, 1024, 4096 };
+  int kbytes = 64, bs = 0, nfiles = 100, depth = 8, writers = 4;
+  int i;
+
+  for(i = 1; i < argc && argv[i][0] == '-'; i += 2){
+    if(i + 1 >= argc)
+      usage();
+    if(strcmp(argv[i], "-s") == 0)
+      kbytes = atoi(argv[i + 1]);
+    else if(strcmp(argv[i], "-b") == 0)
+      bs = atoi(argv[i + 1]);
+    else if(strcmp(argv[i], "-n") == 0)
+      nfiles = atoi(argv[i + 1]);
+    else if(strcmp(argv[i], "-d") == 0)
+      depth = atoi(argv[i + 1]);
+    else if(strcmp(argv[i], "-w") == 0)
+      writers = atoi(argv[i + 1]);
+    else if(strcmp(argv[i], "-l") == 0)
+      label = argv[i + 1];
+    else
+      usage();
+  }
+  if(kbytes < 4 || kbytes > MAXKB ||
+     (bs != 0 && (bs < 1 || bs > MAXBS)) ||
+     nfiles < 1 || nfiles > 1000 || depth < 1 || depth > MAXDEPTH ||
+     writers < 1 || writers > MAXWRITERS){
+    fprintf(2, "fsbench: need 4..%d kbytes, bs 1..%d, 1..1000 files, "
+            "depth 1..%d and 1..%d writers\n",
+            MAXKB, MAXBS, MAXDEPTH, MAXWRITERS);
+    exit(1);
+  }
+  argc -= i;
+  argv += i;
+
+  if(want("seqwrite", argc, argv) || want("seqread", argc, argv) ||
+     want("randwrite", argc, argv) || want("randread", argc, argv)){
+    for(int s = 0; s < sizeof(sizes) / sizeof(sizes[0]); s++)
+      if(bs == 0 || bs == sizes[s])
+        rw(sizes[s], kbytes, argc, argv);
+    if(bs != 0 && bs != 512 && bs != 1024 && bs != 4096)
+      rw(bs, kbytes, argc, argv);
+  }
+  if(want("create", argc, argv) || want("delete", argc, argv))
+    smallfiles(nfiles, argc, argv);
+  if(want("lookup", argc, argv))
+    lookup(depth, 200);
+  if(want("concurrent", argc, argv))
+    concurrent(writers, bs ? bs : 1024, kbytes);
+  exit(0);
+}
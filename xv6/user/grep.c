@@ -11,25 +11,16 @@ int match(char*, char*);
 void
 grep(char *pattern, int fd)
 {
-  int n, m;
-  char *p, *q;
+  int n, nl;
 
-  m = 0;
-  while((n = read(fd, buf+m, sizeof(buf)-m-1)) > 0){
-    m += n;
-    buf[m] = '\0';
-    p = buf;
-    while((q = strchr(p, '\n')) != 0){
-      *q = 0;
-      if(match(pattern, p)){
-        *q = '\n';
-        write(1, p, q+1 - p);
-      }
-      p = q+1;
-    }
-    if(m > 0){
-      m -= p - buf;
-      memmove(buf, p, m);
+  while((n = readline(fd, buf, sizeof(buf))) > 0){
+    nl = buf[n-1] == '\n';
+    if(nl)
+      buf[n-1] = 0;
+    if(match(pattern, buf)){
+      if(nl)
+        buf[n-1] = '\n';
+      write(1, buf, n);
     }
   }
 }
@@ -4,8 +4,8 @@
 // In this version, init also acts as a small input router:
 //   - It is the *only* process that reads from the real console (fd 0).
 //   - It forwards normal lines to the shell via a pipe.
-//   - It forwards lines starting with "ADVICE:PID=" to llmhelper via a
-//     separate pipe.
+//   - It forwards lines starting with "ADVICE:PID=" or "ADVICE:GANG="
+//     to llmhelper via a separate pipe.
 //
 // This keeps the shell interactive on the console, while allowing
 // llmhelper to receive LLM advice without stealing console input.
@@ -24,11 +24,16 @@ char *argv_llm[] = { "llmhelper", 0 };
 
 #define LINE_BUF 512
 
-// Simple helper to check whether a line starts with "ADVICE:PID=".
+// Real-time reservation for the router and llmhelper: advice is
+// only useful if it is applied promptly, so both get RT_RUNTIME
+// ticks in every RT_PERIOD, ahead of the workloads they advise on.
+#define RT_RUNTIME 1
+#define RT_PERIOD  5
+
+// Does s start with prefix?
 static int
-is_advice_line(char *s)
+has_prefix(char *s, const char *prefix)
 {
-  const char *prefix = "ADVICE:PID=";
   int i;
 
   for(i = 0; prefix[i] != 0; i++){
@@ -38,6 +43,14 @@ is_advice_line(char *s)
   return 1;
 }
 
+// Simple helper to check whether a line is advice for llmhelper:
+// "ADVICE:PID=" for a process, "ADVICE:GANG=" for a gang.
+static int
+is_advice_line(char *s)
+{
+  return has_prefix(s, "ADVICE:PID=") || has_prefix(s, "ADVICE:GANG=");
+}
+
 // Router loop: read from the real console (fd 0), one line at a time,
 // and forward it to either the shell pipe (sh_fd) or the llm pipe (llm_fd)
 // depending on the prefix.
@@ -62,17 +75,16 @@ router_loop(int sh_fd, int llm_fd)
     if(c == '\n'){
       buf[n] = 0;
 
-      // Classify and forward this completed line.
+      // Classify and forward this completed line, newline and
+      // all in one write() so a reader never sees half of it.
       if(n > 0 && is_advice_line(buf)){
-        if(llm_fd >= 0){
-          write(llm_fd, buf, n);
-          write(llm_fd, "\n", 1);
-        }
+        buf[n] = '\n';
+        if(llm_fd >= 0)
+          write(llm_fd, buf, n + 1);
       } else {
-        if(sh_fd >= 0){
-          write(sh_fd, buf, n);
-          write(sh_fd, "\n", 1);
-        }
+        buf[n] = '\n';
+        if(sh_fd >= 0)
+          write(sh_fd, buf, n + 1);
       }
 
       n = 0;  // reset buffer for next line
@@ -102,9 +114,11 @@ main(void)
   dup(0);  // stderr
 
   // Create pipes:
-  //   shpipe:   init/router writes, shell reads.
+  //   shpipe:   init/router writes, shell reads. O_LINES hands the
+  //             shell one line per read(), so it can read in bulk
+  //             without taking lines typed ahead for its commands.
   //   llmpipe:  init/router writes, llmhelper reads.
-  if(pipe(shpipe) < 0 || pipe(llmpipe) < 0){
+  if(pipe2(shpipe, O_LINES) < 0 || pipe(llmpipe) < 0){
     printf("init: pipe failed\n");
     exit(1);
   }
@@ -122,6 +136,9 @@ main(void)
     close(shpipe[0]);
     close(llmpipe[0]);
 
+    if(setrealtime(0, RT_RUNTIME, RT_PERIOD, RT_PERIOD) < 0)
+      printf("init: router not admitted to real-time class\n");
+
     // The router inherits fd 0/1/2 pointing at the console.
     // It will read from fd 0 and forward lines into the pipes.
     router_loop(shpipe[1], llmpipe[1]);
@@ -147,6 +164,10 @@ main(void)
     close(llmpipe[0]);   // no longer need the original fd
     close(shpipe[0]);    // not used in this process
 
+    // The reservation survives exec.
+    if(setrealtime(0, RT_RUNTIME, RT_PERIOD, RT_PERIOD) < 0)
+      printf("init: llmhelper not admitted to real-time class\n");
+
     exec("llmhelper", argv_llm);
     printf("init: exec llmhelper failed\n");
     exit(1);
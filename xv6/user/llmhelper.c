@@ -6,9 +6,22 @@
 // llmhelper's stdin via a dedicated pipe, *not* the interactive
 // console. Each line is expected to have the form:
 //
-//   ADVICE:PID=<n> TS=<ts> V=1
+//   ADVICE:PID=<n> TS=<ts> V=1 [SLICE=<ticks>] [AT=<tick>]
+//   ADVICE:GANG=<g> TS=<ts> V=1 [AT=<tick>]
 //
-// Only the PID field matters; everything else is ignored.
+// PID names the process to run next, GANG a gang (see setgang())
+// to run side by side, which set_llm_advice() takes as -g. An optional SLICE also sets
+// that process's time slice (0 = back to the policy's default).
+// Everything else is ignored.
+//
+// Each applied line is echoed as
+//
+//   llmhelper: applied at tick <t>: <line>
+//
+// which sched_log_splitter.py --record saves. AT holds the advice
+// back until uptime() reaches that tick; console_mux.py --replay
+// adds it to recorded advice, so a replay applies each piece at
+// the tick it was recorded at.
 
 #include "kernel/types.h"
 #include "kernel/stat.h"
@@ -16,7 +29,24 @@
 
 #define BUF_SZ 512
 
-// Parse a single line. If it matches ADVICE:PID=<n>..., call set_llm_advice(n).
+// The number after key (e.g. " SLICE=") on line, or -1 if key
+// isn't there or isn't followed by a digit.
+static int
+intfield(char *line, char *key)
+{
+  int i, n = strlen(key);
+
+  for(; *line; line++){
+    for(i = 0; i < n && line[i] == key[i]; i++)
+      ;
+    if(i == n && line[n] >= '0' && line[n] <= '9')
+      return atoi(line + n);
+  }
+  return -1;
+}
+
+// Parse a single line. If it matches ADVICE:PID=<n>..., call set_llm_advice(n);
+// if ADVICE:GANG=<g>..., set_llm_advice(-g).
 static void
 handle_line(char *line)
 {
@@ -25,13 +55,21 @@ handle_line(char *line)
     line++;
 
   const char *prefix = "ADVICE:PID=";
+  const char *gprefix = "ADVICE:GANG=";
   int plen = 11; // strlen("ADVICE:PID=")
+  int gang = 0;
   int i;
 
-  // Require the exact prefix.
-  for(i = 0; i < plen; i++) {
-    if(line[i] != prefix[i])
+  // Require one of the exact prefixes.
+  for(i = 0; i < plen && line[i] == prefix[i]; i++)
+    ;
+  if(i < plen){
+    plen = 12; // strlen("ADVICE:GANG=")
+    for(i = 0; i < plen && line[i] == gprefix[i]; i++)
+      ;
+    if(i < plen)
       return;
+    gang = 1;
   }
 
   char *p = line + plen;
@@ -49,12 +87,32 @@ handle_line(char *line)
   if(pid <= 0)
     return;
 
+  // Replayed advice waits for its tick. We run in the real-time
+  // class, so pause() returns on that very tick.
+  int at = intfield(p, " AT=");
+  if(at >= 0 && at > uptime())
+    pause(at - uptime());
+  int tick = uptime();
+
+  if(gang){
+    if(set_llm_advice(-pid) < 0)
+      printf("llmhelper: advice for gang %d failed\n", pid);
+    else
+      printf("llmhelper: applied at tick %d: %s\n", tick, line);
+    return;
+  }
+
+  // Optional SLICE=<ticks> later on the line.
+  int slice = intfield(p, " SLICE=");
+  if(slice >= 0 && settimeslice(pid, slice) < 0)
+    printf("llmhelper: settimeslice(%d, %d) failed\n", pid, slice);
+
   // Best-effort: ignore errors, but print a hint on failure.
   if(set_llm_advice(pid) < 0) {
     printf("llmhelper: set_llm_advice(%d) failed\n", pid);
   } else {
-    // Lightweight debug so we can see when advice is applied.
-    printf("llmhelper: applied advice for pid %d\n", pid);
+    // Also what sched_log_splitter.py --record looks for.
+    printf("llmhelper: applied at tick %d: %s\n", tick, line);
   }
 }
 
@@ -0,0 +1,162 @@
+// user/mallocbench.c
+// malloc()/free() stress benchmark. Keeps a table of live blocks
+// and, for ops rounds, frees a random slot (if it's full) and
+// mallocs a new block of random size in its place, checking that
+// each block still holds the bytes written into it. Prints one
+// line per size mix:
+//
+//   RESULT bench=mallocbench test=<mix> ops=<n> slots=<s> elapsed_us=<t> op_ns=<t> ops_per_s=<r>
+//
+// where an op is one malloc() plus, once the table is warm, one
+// free().
+//
+// Usage:
+//   mallocbench [-n ops] [-s slots] [mix ...]
+//
+// Mixes (default: all of them):
+//   small   1 .. 128 bytes, like sh's command nodes
+//   mixed   mostly small, every 8th block 1 .. 8K
+//   large   2K .. 16K bytes, past the size classes
+
+#include "kernel/types.h"
+#include "kernel/stat.h"
+#include "user/user.h"
+
+#define MAXSLOTS 1024
+
+static char *slot[MAXSLOTS];
+static uint len[MAXSLOTS];
+static uint rnd = 1;
+
+static uint
+nextrand(void)
+{
+  rnd = rnd * 1103515245 + 12345;
+  return rnd >> 8;
+}
+
+static uint
+size_small(int i)
+{
+  return 1 + nextrand() % 128;
+}
+
+static uint
+size_mixed(int i)
+{
+  if(i % 8 == 0)
+    return 1 + nextrand() % 8192;
+  return 1 + nextrand() % 128;
+}
+
+static uint
+size_large(int i)
+{
+  return 2048 + nextrand() % (14 * 1024);
+}
+
+// The byte block s is filled with.
+static char
+tag(int s)
+{
+  return 'a' + s % 26;
+}
+
+// Check slot s's block and free it; -1 if it was overwritten.
+static int
+release(int s)
+{
+  int bad = 0;
+
+  if(slot[s] == 0)
+    return 0;
+  if(slot[s][0] != tag(s) || slot[s][len[s] - 1] != tag(s))
+    bad = -1;
+  free(slot[s]);
+  slot[s] = 0;
+  return bad;
+}
+
+static void
+run(char *mix, uint (*size)(int), int ops, int nslots)
+{
+  int i, s, bad = 0;
+
+  rnd = 1;
+  uint64 t0 = rdtime();
+  for(i = 0; i < ops; i++){
+    s = nextrand() % nslots;
+    bad |= release(s);
+    len[s] = size(i);
+    if((slot[s] = malloc(len[s])) == 0){
+      fprintf(2, "mallocbench: %s: out of memory after %d ops\n", mix, i);
+      break;
+    }
+    slot[s][0] = slot[s][len[s] - 1] = tag(s);
+  }
+  uint64 t = rdtime() - t0;
+  for(s = 0; s < nslots; s++)
+    bad |= release(s);
+  if(bad){
+    fprintf(2, "mallocbench: %s: a block was overwritten\n", mix);
+    exit(1);
+  }
+
+  printf("RESULT bench=mallocbench test=%s ops=%d slots=%d elapsed_us=%lu op_ns=%lu ops_per_s=%lu\n",
+         mix, i, nslots, t / (TIMEBASE_HZ / 1000000),
+         i ? t * (1000000000 / TIMEBASE_HZ) / i : 0,
+         t ? (uint64)i * TIMEBASE_HZ / t : 0);
+}
+
+struct mix {
+  char *name;
+  uint (*size)(int);
+} mixes[] = {
+  { "small", size_small },
+  { "mixed", size_mixed },
+  { "large", size_large },
+};
+#define NMIX (sizeof(mixes) / sizeof(mixes[0]))
+
+static void
+usage(void)
+{
+  fprintf(2, "usage: mallocbench [-n ops] [-s slots] [mix ...]\n");
+  exit(1);
+}
+
+int
+main(int argc, char *argv[])
+{
+  int ops = 20000, nslots = 256;
+  int i, m, ran = 0;
+
+  for(i = 1; i < argc && argv[i][0] == '-'; i += 2){
+    if(i + 1 >= argc)
+      usage();
+    if(strcmp(argv[i], "-n") == 0)
+      ops = atoi(argv[i + 1]);
+    else if(strcmp(argv[i], "-s") == 0)
+      nslots = atoi(argv[i + 1]);
+    else
+      usage();
+  }
+  if(ops < 1 || nslots < 1 || nslots > MAXSLOTS){
+    fprintf(2, "mallocbench: need ops > 0 and 1..%d slots\n", MAXSLOTS);
+    exit(1);
+  }
+
+  for(m = 0; m < NMIX; m++){
+    int want = i == argc;
+    for(int j = i; j < argc; j++)
+      if(strcmp(argv[j], mixes[m].name) == 0)
+        want = 1;
+    if(want){
+      run(mixes[m].name, mixes[m].size, ops, nslots);
+      ran++;
+    }
+  }
+  if(ran == 0)
+    usage();
+  exit(0);
+}
@@ -0,0 +1,324 @@
+// user/microbench.c
+// lmbench-style microbenchmarks of the kernel primitives our
+// workloads lean on. Each test runs some warmup repetitions, then
+// times reps more with rdtime() and prints one line:
+//
+//   RESULT bench=microbench test=<name> reps=<n> batch=<b> min_ns=.. median_ns=.. p99_ns=..
+//
+// Times are per operation; operations too quick for the 100ns
+// time CSR are timed in batches of b and divided.
+//
+// Usage:
+//   microbench [-r reps] [-w warmup] [test ...]
+//
+// Tests (default: all of them):
+//   syscall     null system call (the trapping getpid())
+//   fork        fork() + exit() + wait()
+//   exec        fork() + exec() of a program that exits + wait()
+//   pipe        1-byte round trip between two processes over pipes
+//   ctxsw       yield() between two processes pinned to hart 0;
+//               one context switch
+//   pagefault   first touch of a lazily sbrk()ed page
+//   bread_hit   read() of a 1K block found in the buffer cache
+//   bread_miss  read() of a 1K block that has to come from disk
+
+#include "kernel/types.h"
+#include "kernel/stat.h"
+#include "kernel/fcntl.h"
+#include "kernel/riscv.h"
+#include "user/user.h"
+
+#define MAXREPS 1000
+#define BLK 1024
+
+static int reps = 200, warmup = 20;
+static uint64 samples[MAXREPS];
+static char buf[BLK];
+static char *self;             // argv[0], for bench_exec()
+
+// Sort samples[0..n) and print the RESULT line for test name,
+// whose samples each cover batch operations.
+static void
+report(char *name, int n, int batch)
+{
+  int i, j, gap;
+  uint64 t;
+
+  for(gap = n / 2; gap > 0; gap /= 2)
+    for(i = gap; i < n; i++)
+      for(j = i - gap; j >= 0 && samples[j] > samples[j + gap]; j -= gap){
+        t = samples[j];
+        samples[j] = samples[j + gap];
+        samples[j + gap] = t;
+      }
+
+  // time CSR units (100ns at TIMEBASE_HZ) per operation, in ns.
+  #define NS(x) ((x) * (1000000000 / TIMEBASE_HZ) / batch)
+  printf("RESULT bench=microbench test=%s reps=%d batch=%d min_ns=%lu median_ns=%lu p99_ns=%lu\n",
+         name, n, batch, NS(samples[0]), NS(samples[n / 2]), NS(samples[n * 99 / 100]));
+  #undef NS
+}
+
+static void
+bench_syscall(void)
+{
+  int batch = 100;
+
+  for(int r = -warmup; r < reps; r++){
+    uint64 t0 = rdtime();
+    for(int i = 0; i < batch; i++)
+      sys_getpid();
+    if(r >= 0)
+      samples[r] = rdtime() - t0;
+  }
+  report("syscall", reps, batch);
+}
+
+static void
+bench_fork(void)
+{
+  for(int r = -warmup; r < reps; r++){
+    uint64 t0 = rdtime();
+    int pid = fork();
+    if(pid < 0){
+      fprintf(2, "microbench: fork failed\n");
+      return;
+    }
+    if(pid == 0)
+      exit(0);
+    wait(0);
+    if(r >= 0)
+      samples[r] = rdtime() - t0;
+  }
+  report("fork", reps, 1);
+}
+
+static void
+bench_exec(void)
+{
+  char *argv[] = { self, "-x", 0 };
+
+  for(int r = -warmup; r < reps; r++){
+    uint64 t0 = rdtime();
+    int pid = fork();
+    if(pid < 0){
+      fprintf(2, "microbench: fork failed\n");
+      return;
+    }
+    if(pid == 0){
+      exec(argv[0], argv);
+      fprintf(2, "microbench: exec %s failed\n", argv[0]);
+      exit(1);
+    }
+    wait(0);
+    if(r >= 0)
+      samples[r] = rdtime() - t0;
+  }
+  report("exec", reps, 1);
+}
+
+static void
+bench_pipe(void)
+{
+  int ping[2], pong[2];
+  char c = 0;
+
+  if(pipe(ping) < 0 || pipe(pong) < 0){
+    fprintf(2, "microbench: pipe failed\n");
+    return;
+  }
+  int pid = fork();
+  if(pid == 0){
+    close(ping[1]);
+    close(pong[0]);
+    while(read(ping[0], &c, 1) == 1)
+      write(pong[1], &c, 1);
+    exit(0);
+  }
+  close(ping[0]);
+  close(pong[1]);
+  for(int r = -warmup; r < reps; r++){
+    uint64 t0 = rdtime();
+    write(ping[1], &c, 1);
+    read(pong[0], &c, 1);
+    if(r >= 0)
+      samples[r] = rdtime() - t0;
+  }
+  close(ping[1]);
+  close(pong[0]);
+  wait(0);
+  report("pipe", reps, 1);
+}
+
+static void
+bench_ctxsw(void)
+{
+  int batch = 20;
+  int old = setaffinity(0, 1);
+
+  // the child inherits the affinity, so the two share hart 0 and
+  // each yield() switches to the other: two switches per round.
+  int pid = fork();
+  if(pid == 0){
+    for(;;)
+      yield();
+  }
+  for(int r = -warmup; r < reps; r++){
+    uint64 t0 = rdtime();
+    for(int i = 0; i < batch; i++)
+      yield();
+    if(r >= 0)
+      samples[r] = rdtime() - t0;
+  }
+  kill(pid);
+  wait(0);
+  setaffinity(0, old);
+  report("ctxsw", reps, 2 * batch);
+}
+
+static void
+bench_pagefault(void)
+{
+  int batch = 16;
+
+  for(int r = -warmup; r < reps; r++){
+    char *p = sbrklazy(batch * PGSIZE);
+    if(p == (char *)-1){
+      fprintf(2, "microbench: sbrklazy failed\n");
+      return;
+    }
+    uint64 t0 = rdtime();
+    for(int i = 0; i < batch; i++)
+      p[i * PGSIZE] = 1;
+    if(r >= 0)
+      samples[r] = rdtime() - t0;
+    sbrk(-batch * PGSIZE);
+  }
+  report("pagefault", reps, batch);
+}
+
+// Create file name of nblocks 1K blocks.
+static int
+mkfile(char *name, int nblocks)
+{
+  int fd = open(name, O_CREATE | O_TRUNC | O_WRONLY);
+
+  if(fd < 0)
+    return -1;
+  memset(buf, 'm', BLK);
+  for(int i = 0; i < nblocks; i++){
+    if(write(fd, buf, BLK) != BLK){
+      close(fd);
+      return -1;
+    }
+  }
+  close(fd);
+  return 0;
+}
+
+// Time reading name one block at a time, starting over at the end.
+// A file smaller than the buffer cache stays in it; one several
+// times larger, read in order, misses on every block (the cache
+// is LRU).
+static void
+bench_read(char *test, char *name, int nblocks)
+{
+  int fd, r;
+
+  if(mkfile(name, nblocks) < 0){
+    fprintf(2, "microbench: cannot create %s\n", name);
+    return;
+  }
+  if((fd = open(name, O_RDONLY)) < 0)
+    return;
+  for(r = -warmup; r < reps; ){
+    uint64 t0 = rdtime();
+    int n = read(fd, buf, BLK);
+    uint64 t = rdtime() - t0;
+    if(n != BLK){
+      close(fd);
+      fd = open(name, O_RDONLY);
+      continue;
+    }
+    if(r >= 0)
+      samples[r] = t;
+    r++;
+  }
+  close(fd);
+  unlink(name);
+  report(test, reps, 1);
+}
+
+static void
+bench_bread_hit(void)
+{
+  bench_read("bread_hit", "mb.hit", 4);
+}
+
+static void
+bench_bread_miss(void)
+{
+  bench_read("bread_miss", "mb.miss", 120);
+}
+
+struct test {
+  char *name;
+  void (*fn)(void);
+} tests[] = {
+  { "syscall",    bench_syscall },
+  { "fork",       bench_fork },
+  { "exec",       bench_exec },
+  { "pipe",       bench_pipe },
+  { "ctxsw",      bench_ctxsw },
+  { "pagefault",  bench_pagefault },
+  { "bread_hit",  bench_bread_hit },
+  { "bread_miss", bench_bread_miss },
+};
+#define NTEST (sizeof(tests) / sizeof(tests[0]))
+
+static void
+usage(void)
+{
+  fprintf(2, "usage: microbench [-r reps] [-w warmup] [test ...]\n");
+  exit(1);
+}
+
+int
+main(int argc, char *argv[])
+{
+  int i, t, ran = 0;
+
+  // the program bench_exec() runs.
+  if(argc == 2 && strcmp(argv[1], "-x") == 0)
+    exit(0);
+  self = argv[0];
+
+  for(i = 1; i < argc && argv[i][0] == '-'; i += 2){
+    if(i + 1 >= argc)
+      usage();
+    if(strcmp(argv[i], "-r") == 0)
+      reps = atoi(argv[i + 1]);
+    else if(strcmp(argv[i], "-w") == 0)
+      warmup = atoi(argv[i + 1]);
+    else
+      usage();
+  }
+  if(reps < 1 || reps > MAXREPS || warmup < 0){
+    fprintf(2, "microbench: reps must be 1..%d\n", MAXREPS);
+    exit(1);
+  }
+
+  for(t = 0; t < NTEST; t++){
+    int want = i == argc;
+    for(int j = i; j < argc; j++)
+      if(strcmp(argv[j], tests[t].name) == 0)
+        want = 1;
+    if(want){
+      tests[t].fn();
+      ran++;
+    }
+  }
+  if(ran == 0)
+    usage();
+  exit(0);
+}
@@ -5,16 +5,19 @@
 // You can also run multiple worker processes, like cpubound/iobound.
 //
 // Usage:
-//   mixed [iterations] [inner_loops] [sleep_ticks] [workers]
+//   mixed [iterations] [inner_loops] [sleep_ticks] [workers] [gang]
 //
 // Defaults:
 //   iterations   = 150      // outer iterations
 //   inner_loops  = 50000    // CPU loop per iteration
 //   sleep_ticks  = 20       // pause() ticks after each burst
 //   workers      = 1        // parent only (no extra children)
+//   gang         = 0        // 1: gang-schedule the workers (setgang())
 //
 // With these defaults and ticks ≈10ms, each worker sleeps for about
-// 150 * 20 = 3000 ticks (≈30 seconds), plus CPU bursts.
+// 150 * 20 = 3000 ticks (≈30 seconds), plus CPU bursts. The parent
+// reports the completion skew: ticks between the first and the last
+// worker finishing.
 
 #include "kernel/types.h"
 #include "kernel/stat.h"
@@ -27,6 +30,7 @@ main(int argc, char *argv[])
   int inner_loops = 50000;
   int sleep_ticks = 20;
   int workers     = 1;   // parent + children (total worker processes)
+  int gang        = 0;   // gang-schedule the workers?
 
   if(argc >= 2){
     int v = atoi(argv[1]);
@@ -48,6 +52,8 @@ main(int argc, char *argv[])
     if(v > 0)
       workers = v;
   }
+  if(argc >= 6)
+    gang = atoi(argv[5]) != 0;
 
   // Clamp workers to a sane range.
   if(workers < 1)
@@ -57,8 +63,12 @@ main(int argc, char *argv[])
 
   int parent_pid = getpid();
 
-  printf("mixed: parent pid=%d, workers=%d, iterations=%d, inner_loops=%d, sleep=%d\n",
-         parent_pid, workers, iterations, inner_loops, sleep_ticks);
+  printf("mixed: parent pid=%d, workers=%d, iterations=%d, inner_loops=%d, sleep=%d, gang=%d\n",
+         parent_pid, workers, iterations, inner_loops, sleep_ticks, gang);
+
+  // The children inherit the gang; the parent's pid names it.
+  if(gang && setgang(0, parent_pid) < 0)
+    printf("mixed: setgang failed, running ungrouped\n");
 
   // Fork workers-1 children; each child breaks out and runs the mixed loop.
   for(int i = 0; i < workers - 1; i++){
@@ -90,17 +100,29 @@ main(int argc, char *argv[])
       pause(sleep_ticks);
   }
 
+  int finished = uptime();
+  if(gang)
+    setgang(0, 0);
+
   // Use x so the compiler keeps the CPU work.
   printf("mixed(pid=%d): finished (final x=%d)\n", mypid, x);
 
   // Only the original parent waits for children, to avoid zombies.
+  // Children report the tick they finished as their exit status.
   if(mypid == parent_pid){
-    int w;
-    while((w = wait(0)) > 0){
+    int w, status;
+    int first = finished, last = finished;
+    while((w = wait(&status)) > 0){
       printf("mixed: child %d exited\n", w);
+      if(status < first)
+        first = status;
+      if(status > last)
+        last = status;
     }
-    printf("mixed(pid=%d): all children finished\n", parent_pid);
+    printf("mixed(pid=%d): all children finished, completion skew=%d ticks\n",
+           parent_pid, last - first);
+    exit(0);
   }
 
-  exit(0);
+  exit(finished);
 }
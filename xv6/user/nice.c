@@ -0,0 +1,70 @@
+// user/nice.c
+// Run a command at a different nice value, or renice a process.
+//
+// Usage:
+//   nice <n> <cmd> [args...]   run cmd at nice n
+//   nice -p <n> <pid>          set the nice value of a running process
+//   nice -g <pid>              print the nice value of a process
+//
+// n runs from -20 (longest quanta, never skipped) to 19 (shortest
+// quanta, passed over by round-robin most often); 0 is the default.
+// The value is inherited by children.
+
+#include "kernel/types.h"
+#include "kernel/stat.h"
+#include "user/user.h"
+
+static void
+usage(void)
+{
+  fprintf(2, "usage: nice <n> <cmd> [args...]\n"
+             "       nice -p <n> <pid>\n"
+             "       nice -g <pid>\n");
+  exit(1);
+}
+
+// atoi() that accepts a leading minus sign.
+static int
+satoi(char *s)
+{
+  if(*s == '-')
+    return -atoi(s + 1);
+  return atoi(s);
+}
+
+int
+main(int argc, char *argv[])
+{
+  int n;
+
+  if(argc == 3 && strcmp(argv[1], "-g") == 0){
+    if(getpriority(atoi(argv[2]), &n) < 0){
+      fprintf(2, "nice: no process %s\n", argv[2]);
+      exit(1);
+    }
+    printf("pid %s: nice %d\n", argv[2], n);
+    exit(0);
+  }
+
+  if(argc >= 2 && strcmp(argv[1], "-p") == 0){
+    if(argc != 4)
+      usage();
+    if(setpriority(atoi(argv[3]), satoi(argv[2])) < 0){
+      fprintf(2, "nice: cannot renice pid %s\n", argv[3]);
+      exit(1);
+    }
+    getpriority(atoi(argv[3]), &n);
+    printf("pid %s: nice %d\n", argv[3], n);
+    exit(0);
+  }
+
+  if(argc < 3)
+    usage();
+  if(setpriority(0, satoi(argv[1])) < 0){
+    fprintf(2, "nice: bad value %s\n", argv[1]);
+    exit(1);
+  }
+  exec(argv[2], argv + 2);
+  fprintf(2, "nice: exec %s failed\n", argv[2]);
+  exit(1);
+}
@@ -0,0 +1,147 @@
+// user/ringbench.c
+// Compares the per-op cost of plain system calls against the same
+// operations batched through the uring (see kernel/uring.h).
+//
+// Tests:
+//   null  - sys_getpid() per op vs URING_OP_NOP submissions
+//   pipe  - write()+read() of one byte through a pipe per op vs
+//           the same WRITE/READ pair as two submissions
+//
+// Usage:
+//   ringbench [ops] [batch]
+//
+//   ops    - operations per test (default 200000)
+//   batch  - submissions per uring_enter() (default 32,
+//            at most URING_ENTRIES)
+//
+// Ticks are coarse (about 100ms), so keep ops large. Per-op cost
+// is reported in microticks (ticks * 1000000 / ops).
+
+#include "kernel/types.h"
+#include "kernel/stat.h"
+#include "kernel/uring.h"
+#include "user/user.h"
+
+static struct uring *ring;
+
+// Queue one submission. The caller makes sure there is room.
+static void
+submit(int op, int fd, void *addr, int len)
+{
+  struct uring_sqe *sqe = &ring->sq[ring->sq_tail % URING_ENTRIES];
+
+  sqe->op = op;
+  sqe->fd = fd;
+  sqe->addr = (uint64)addr;
+  sqe->len = len;
+  sqe->user_data = ring->sq_tail;
+  __sync_synchronize();
+  ring->sq_tail++;
+}
+
+// Hand all queued submissions to the kernel and
+// consume their completions. Exits on any failed op.
+static void
+flush(void)
+{
+  int n = ring->sq_tail - ring->sq_head;
+
+  if(uring_enter(n) != n){
+    printf("ringbench: uring_enter(%d) fell short\n", n);
+    exit(1);
+  }
+  while(ring->cq_head != ring->cq_tail){
+    struct uring_cqe *cqe = &ring->cq[ring->cq_head % URING_ENTRIES];
+    if(cqe->res < 0){
+      printf("ringbench: op %d failed\n", cqe->user_data);
+      exit(1);
+    }
+    ring->cq_head++;
+  }
+}
+
+static void
+report(char *name, int ops, int batch, int plain, int batched)
+{
+  printf("ringbench: %s ops=%d batch=%d syscall=%d ticks (%lu uticks/op) "
+         "ring=%d ticks (%lu uticks/op)\n",
+         name, ops, batch,
+         plain, (uint64)plain * 1000000 / ops,
+         batched, (uint64)batched * 1000000 / ops);
+}
+
+int
+main(int argc, char *argv[])
+{
+  int ops   = 200000;
+  int batch = 32;
+  int fds[2];
+  char c = 'x';
+  int t0, plain, batched;
+
+  if(argc >= 2){
+    int v = atoi(argv[1]);
+    if(v > 0)
+      ops = v;
+  }
+  if(argc >= 3){
+    int v = atoi(argv[2]);
+    if(v > 0)
+      batch = v;
+  }
+
+  // Each pipe op is a WRITE+READ pair, so keep batch even.
+  if(batch > URING_ENTRIES)
+    batch = URING_ENTRIES;
+  if(batch < 2)
+    batch = 2;
+  batch &= ~1;
+
+  if((ring = uring_setup()) == (struct uring *)-1){
+    printf("ringbench: uring_setup failed\n");
+    exit(1);
+  }
+  if(pipe(fds) < 0){
+    printf("ringbench: pipe failed\n");
+    exit(1);
+  }
+
+  // null: trap cost alone.
+  t0 = uptime();
+  for(int i = 0; i < ops; i++)
+    sys_getpid();
+  plain = uptime() - t0;
+
+  t0 = uptime();
+  for(int i = 0; i < ops; i++){
+    submit(URING_OP_NOP, 0, 0, 0);
+    if((i + 1) % batch == 0)
+      flush();
+  }
+  flush();
+  batched = uptime() - t0;
+  report("null", ops, batch, plain, batched);
+
+  // pipe: a one-byte round trip through the pipe buffer.
+  t0 = uptime();
+  for(int i = 0; i < ops; i++){
+    if(write(fds[1], &c, 1) != 1 || read(fds[0], &c, 1) != 1){
+      printf("ringbench: pipe write/read failed\n");
+      exit(1);
+    }
+  }
+  plain = uptime() - t0;
+
+  t0 = uptime();
+  for(int i = 0; i < ops; i++){
+    submit(URING_OP_WRITE, fds[1], &c, 1);
+    submit(URING_OP_READ, fds[0], &c, 1);
+    if((i + 1) % (batch / 2) == 0)
+      flush();
+  }
+  flush();
+  batched = uptime() - t0;
+  report("pipe", ops, batch, plain, batched);
+
+  exit(0);
+}
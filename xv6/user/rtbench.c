@@ -0,0 +1,126 @@
+// user/rtbench.c
+// Measures advice-application latency under full CPU load, with the
+// advice path in the round-robin class and then in the real-time
+// (EDF) class.
+//
+// Mirrors the router -> llmhelper path: a sender wakes every
+// <interval> ticks and writes the current tick into a pipe, and a
+// receiver reads it and applies set_llm_advice() naming one of the
+// CPU hogs, recording how many ticks passed since the send. Both
+// compete with <hogs> busy-looping processes.
+//
+// Usage:
+//   rtbench [hogs] [rounds] [interval]
+//
+//   hogs      - CPU-bound competitors (default 6)
+//   rounds    - advice messages per run (default 20)
+//   interval  - ticks between messages (default 3)
+//
+// Latencies are in ticks (about 100ms), so the interesting numbers
+// are the mean and max: a few ticks under round-robin, close to
+// zero in the real-time class.
+
+#include "kernel/types.h"
+#include "kernel/stat.h"
+#include "user/user.h"
+
+#define RT_RUNTIME 1
+#define RT_PERIOD  5
+
+static int hogs = 6;
+static int rounds = 20;
+static int interval = 3;
+
+static void
+hog(void)
+{
+  volatile unsigned x = 0;
+
+  for(;;)
+    x++;
+}
+
+// Receive rounds stamps on fd, apply advice for target on each,
+// and report total and max latency on out.
+static void
+receiver(int fd, int out, int target)
+{
+  int stamp, lat, res[2] = { 0, 0 };
+
+  for(int i = 0; i < rounds; i++){
+    if(read(fd, &stamp, sizeof(stamp)) != sizeof(stamp))
+      break;
+    set_llm_advice(target);
+    lat = uptime() - stamp;
+    res[0] += lat;
+    if(lat > res[1])
+      res[1] = lat;
+  }
+  write(out, res, sizeof(res));
+  exit(0);
+}
+
+static void
+run(int rt)
+{
+  int pids[64], data[2], back[2], res[2], i, n;
+
+  n = hogs < 64 ? hogs : 64;
+  for(i = 0; i < n; i++){
+    if((pids[i] = fork()) == 0)
+      hog();
+  }
+
+  if(pipe(data) < 0 || pipe(back) < 0){
+    printf("rtbench: pipe failed\n");
+    exit(1);
+  }
+  if(fork() == 0){
+    close(data[1]);
+    close(back[0]);
+    if(rt && setrealtime(0, RT_RUNTIME, RT_PERIOD, RT_PERIOD) < 0)
+      printf("rtbench: receiver not admitted\n");
+    receiver(data[0], back[1], pids[0]);
+  }
+  close(data[0]);
+  close(back[1]);
+  if(rt && setrealtime(0, RT_RUNTIME, RT_PERIOD, RT_PERIOD) < 0)
+    printf("rtbench: sender not admitted\n");
+
+  for(i = 0; i < rounds; i++){
+    pause(interval);
+    int stamp = uptime();
+    write(data[1], &stamp, sizeof(stamp));
+  }
+
+  res[0] = res[1] = -1;
+  read(back[0], res, sizeof(res));
+  close(data[1]);
+  close(back[0]);
+  if(rt)
+    setrealtime(0, 0, 0, 0);
+
+  for(i = 0; i < n; i++)
+    kill(pids[i]);
+  for(i = 0; i < n + 1; i++)
+    wait(0);
+
+  printf("rtbench: %s hogs=%d rounds=%d mean=%d.%d max=%d ticks\n",
+         rt ? "rt" : "rr", n, rounds,
+         res[0] / rounds, (res[0] * 10 / rounds) % 10, res[1]);
+}
+
+int
+main(int argc, char *argv[])
+{
+  if(argc >= 2 && atoi(argv[1]) > 0)
+    hogs = atoi(argv[1]);
+  if(argc >= 3 && atoi(argv[2]) > 0)
+    rounds = atoi(argv[2]);
+  if(argc >= 4 && atoi(argv[3]) > 0)
+    interval = atoi(argv[3]);
+
+  run(0);
+  run(1);
+  exit(0);
+}
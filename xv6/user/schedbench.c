@@ -0,0 +1,209 @@
+// user/schedbench.c
+// Scheduler benchmark: runs CPU-bound, I/O-bound and mixed workers
+// side by side and prints one machine-readable RESULT line per run,
+// so host scripts can compare policies and advisor settings.
+//
+// Usage:
+//   schedbench [-c n] [-i n] [-m n] [-u units] [-b burst] [-l label] [-v]
+//
+//   -c n       CPU-bound workers (default 2)
+//   -i n       I/O-bound workers (default 2)
+//   -m n       mixed workers (default 1)
+//   -u units   units of work per worker (default 20)
+//   -b burst   loop iterations in one CPU burst (default 500000)
+//   -l label   tag copied into the RESULT line (default "-")
+//   -v         also print a WORKER line per worker
+//
+// A unit of work is a CPU burst for a cpu worker, pause(1) and a
+// burst of a tenth the size for an io worker, and a burst then
+// pause(1) for a mixed worker. At most 16 workers in all.
+//
+// Per worker, timed with rdtime():
+//   response     fork() to the child's first instruction
+//   turnaround   fork() to the child finishing its work
+// and overall, throughput as units of work completed per second.
+// The RESULT line has the average and maximum of each per kind
+// of worker, in microseconds:
+//
+//   RESULT bench=schedbench label=<l> policy=<p> cpu=<n> io=<n> mixed=<n>
+//     units=<u> burst=<b> elapsed_us=<t> units_per_s=<r>
+//     cpu_resp_avg_us=.. cpu_resp_max_us=.. cpu_turn_avg_us=.. cpu_turn_max_us=..
+//     io_...  mixed_...
+//
+// (all on one line).
+
+#include "kernel/types.h"
+#include "kernel/stat.h"
+#include "kernel/schedpolicy.h"
+#include "user/user.h"
+
+#define MAXWORKERS 16
+
+enum { CPU, IO, MIXED, NKIND };
+
+static char *kindname[NKIND] = { "cpu", "io", "mixed" };
+static char *policyname[NSCHEDPOLICY] = SCHED_POLICY_NAMES;
+
+// What a worker sends back through the pipe. Small enough that
+// MAXWORKERS of them fit in a pipe, so writes never interleave.
+struct rec {
+  int kind;
+  int pid;
+  uint64 resp;                 // rdtime() units
+  uint64 turn;
+};
+
+static volatile int sink;
+
+static void
+burst(int n)
+{
+  for(int i = 0; i < n; i++)
+    sink += i;
+}
+
+static uint64
+us(uint64 t)
+{
+  return t / (TIMEBASE_HZ / 1000000);
+}
+
+static void
+worker(int kind, int units, int iters, uint64 forked, int fd)
+{
+  struct rec r;
+
+  r.resp = rdtime() - forked;
+  for(int u = 0; u < units; u++){
+    switch(kind){
+    case CPU:
+      burst(iters);
+      break;
+    case IO:
+      pause(1);
+      burst(iters / 10);
+      break;
+    case MIXED:
+      burst(iters);
+      pause(1);
+      break;
+    }
+  }
+  r.turn = rdtime() - forked;
+  r.kind = kind;
+  r.pid = getpid();
+  write(fd, &r, sizeof(r));
+  exit(0);
+}
+
+static void
+usage(void)
+{
+  fprintf(2, "usage: schedbench [-c n] [-i n] [-m n] [-u units] [-b burst] [-l label] [-v]\n");
+  exit(1);
+}
+
+int
+main(int argc, char *argv[])
+{
+  int n[NKIND] = { 2, 2, 1 };
+  int units = 20, iters = 500000, verbose = 0;
+  char *label = "-";
+  int fds[2], i, k, total;
+  uint64 start, elapsed;
+  uint64 respsum[NKIND], respmax[NKIND], turnsum[NKIND], turnmax[NKIND];
+  int done[NKIND];
+  struct rec r;
+
+  for(i = 1; i < argc; i++){
+    if(strcmp(argv[i], "-v") == 0){
+      verbose = 1;
+      continue;
+    }
+    if(i + 1 >= argc)
+      usage();
+    if(strcmp(argv[i], "-c") == 0)
+      n[CPU] = atoi(argv[++i]);
+    else if(strcmp(argv[i], "-i") == 0)
+      n[IO] = atoi(argv[++i]);
+    else if(strcmp(argv[i], "-m") == 0)
+      n[MIXED] = atoi(argv[++i]);
+    else if(strcmp(argv[i], "-u") == 0)
+      units = atoi(argv[++i]);
+    else if(strcmp(argv[i], "-b") == 0)
+      iters = atoi(argv[++i]);
+    else if(strcmp(argv[i], "-l") == 0)
+      label = argv[++i];
+    else
+      usage();
+  }
+  total = n[CPU] + n[IO] + n[MIXED];
+  if(total < 1 || total > MAXWORKERS || units < 1 || iters < 1){
+    fprintf(2, "schedbench: need 1..%d workers and positive units and burst\n",
+            MAXWORKERS);
+    exit(1);
+  }
+
+  if(pipe(fds) < 0){
+    fprintf(2, "schedbench: pipe failed\n");
+    exit(1);
+  }
+
+  start = rdtime();
+  for(k = 0; k < NKIND; k++){
+    for(i = 0; i < n[k]; i++){
+      uint64 t = rdtime();
+      int pid = fork();
+      if(pid < 0){
+        fprintf(2, "schedbench: fork failed\n");
+        exit(1);
+      }
+      if(pid == 0){
+        close(fds[0]);
+        worker(k, units, iters, t, fds[1]);
+      }
+    }
+  }
+  close(fds[1]);
+
+  for(k = 0; k < NKIND; k++){
+    respsum[k] = respmax[k] = turnsum[k] = turnmax[k] = 0;
+    done[k] = 0;
+  }
+  while(read(fds[0], &r, sizeof(r)) == sizeof(r)){
+    k = r.kind;
+    done[k]++;
+    respsum[k] += r.resp;
+    turnsum[k] += r.turn;
+    if(r.resp > respmax[k])
+      respmax[k] = r.resp;
+    if(r.turn > turnmax[k])
+      turnmax[k] = r.turn;
+    if(verbose)
+      printf("WORKER bench=schedbench pid=%d kind=%s resp_us=%lu turn_us=%lu\n",
+             r.pid, kindname[k], us(r.resp), us(r.turn));
+  }
+  while(wait(0) > 0)
+    ;
+  elapsed = rdtime() - start;
+  close(fds[0]);
+
+  int units_done = 0;
+  for(k = 0; k < NKIND; k++)
+    units_done += done[k] * units;
+
+  printf("RESULT bench=schedbench label=%s policy=%s cpu=%d io=%d mixed=%d "
+         "units=%d burst=%d elapsed_us=%lu units_per_s=%lu",
+         label, policyname[setschedpolicy(-1)], n[CPU], n[IO], n[MIXED],
+         units, iters, us(elapsed),
+         elapsed ? (uint64)units_done * TIMEBASE_HZ / elapsed : 0);
+  for(k = 0; k < NKIND; k++){
+    if(done[k] == 0)
+      continue;
+    printf(" %s_resp_avg_us=%lu %s_resp_max_us=%lu %s_turn_avg_us=%lu %s_turn_max_us=%lu",
+           kindname[k], us(respsum[k] / done[k]), kindname[k], us(respmax[k]),
+           kindname[k], us(turnsum[k] / done[k]), kindname[k], us(turnmax[k]));
+  }
+  printf("\n");
+  exit(0);
+}
@@ -0,0 +1,62 @@
+// user/schedgrp.c
+// Run a command, or move an existing process, in a scheduling group.
+//
+// Usage:
+//   schedgrp <gid> <share> <cmd> [args...]   run cmd in group gid
+//   schedgrp -p <gid> <pid>                  move a running process
+//   schedgrp -s <gid> <share>                only set a group's share
+//
+// Round-robin first divides the CPU between groups in proportion
+// to their share (default 100; 0 leaves it unchanged), then between
+// the processes of a group. Children inherit the group, so e.g.
+//   schedgrp 1 100 cpubound 80000000 8 &
+//   schedgrp 2 100 iobound &
+// gives both workload families half the CPU however many workers
+// each one forks.
+
+#include "kernel/types.h"
+#include "kernel/stat.h"
+#include "user/user.h"
+
+static void
+usage(void)
+{
+  fprintf(2, "usage: schedgrp <gid> <share> <cmd> [args...]\n"
+             "       schedgrp -p <gid> <pid>\n"
+             "       schedgrp -s <gid> <share>\n");
+  exit(1);
+}
+
+int
+main(int argc, char *argv[])
+{
+  if(argc >= 2 && strcmp(argv[1], "-p") == 0){
+    if(argc != 4)
+      usage();
+    if(setschedgroup(atoi(argv[3]), atoi(argv[2]), 0) < 0){
+      fprintf(2, "schedgrp: cannot move pid %s to group %s\n", argv[3], argv[2]);
+      exit(1);
+    }
+    exit(0);
+  }
+
+  if(argc >= 2 && strcmp(argv[1], "-s") == 0){
+    if(argc != 4)
+      usage();
+    if(setschedgroup(-1, atoi(argv[2]), atoi(argv[3])) < 0){
+      fprintf(2, "schedgrp: cannot set share of group %s\n", argv[2]);
+      exit(1);
+    }
+    exit(0);
+  }
+
+  if(argc < 4)
+    usage();
+  if(setschedgroup(0, atoi(argv[1]), atoi(argv[2])) < 0){
+    fprintf(2, "schedgrp: bad group %s or share %s\n", argv[1], argv[2]);
+    exit(1);
+  }
+  exec(argv[3], argv + 3);
+  fprintf(2, "schedgrp: exec %s failed\n", argv[3]);
+  exit(1);
+}
@@ -0,0 +1,85 @@
+// user/schedpolicy.c
+// Show or switch the kernel's scheduling policy.
+//
+// Usage:
+//   schedpolicy                 print the current policy and the choices
+//   schedpolicy <name>          switch to policy name (or its number)
+//   schedpolicy -q <ticks>      set the current policy's time slice
+//   schedpolicy -q <ticks> <pid>  set pid's time slice (0 = policy's)
+//   schedpolicy -s <ticks>      set the starvation bound (0 = off)
+//
+// The policy decides what ordinary user processes run once kernel
+// threads and the real-time class have had their turn; see
+// kernel/schedpolicy.h. Switching takes effect at once on every CPU,
+// so policies can be benchmarked back to back in one boot.
+
+#include "kernel/types.h"
+#include "kernel/stat.h"
+#include "kernel/schedpolicy.h"
+#include "user/user.h"
+
+static char *names[NSCHEDPOLICY] = SCHED_POLICY_NAMES;
+
+static int
+lookup(char *s)
+{
+  int i;
+
+  for(i = 0; i < NSCHEDPOLICY; i++)
+    if(strcmp(s, names[i]) == 0)
+      return i;
+  if(*s >= '0' && *s <= '9' && atoi(s) < NSCHEDPOLICY)
+    return atoi(s);
+  return -1;
+}
+
+int
+main(int argc, char *argv[])
+{
+  int id, old, i;
+
+  if(argc == 1){
+    id = setschedpolicy(-1);
+    printf("policy: %s, slice %d, starvation bound %d\n",
+           names[id], settimeslice(-1, 0), setstarvebound(-1));
+    printf("available:");
+    for(i = 0; i < NSCHEDPOLICY; i++)
+      printf(" %s", names[i]);
+    printf("\n");
+    exit(0);
+  }
+
+  if(strcmp(argv[1], "-q") == 0 && (argc == 3 || argc == 4)){
+    int pid = argc == 4 ? atoi(argv[3]) : -1;
+    if(pid < 0 && atoi(argv[2]) <= 0){
+      fprintf(2, "schedpolicy: a policy's slice must be at least 1\n");
+      exit(1);
+    }
+    if((old = settimeslice(pid, atoi(argv[2]))) < 0){
+      fprintf(2, "schedpolicy: cannot set slice %s\n", argv[2]);
+      exit(1);
+    }
+    printf("%s%s: slice %d -> %d\n", argc == 4 ? "pid " : "policy",
+           argc == 4 ? argv[3] : "", old, atoi(argv[2]));
+    exit(0);
+  }
+
+  if(strcmp(argv[1], "-s") == 0 && argc == 3){
+    old = setstarvebound(atoi(argv[2]));
+    printf("starvation bound: %d -> %d\n", old, atoi(argv[2]));
+    exit(0);
+  }
+
+  if(argc != 2){
+    fprintf(2, "usage: schedpolicy [name]\n"
+               "       schedpolicy -q <ticks> [pid]\n"
+               "       schedpolicy -s <ticks>\n");
+    exit(1);
+  }
+  if((id = lookup(argv[1])) < 0 || (old = setschedpolicy(id)) < 0){
+    fprintf(2, "schedpolicy: unknown policy %s\n", argv[1]);
+    exit(1);
+  }
+  printf("policy: %s -> %s\n", names[old], names[id]);
+  exit(0);
+}
@@ -135,9 +135,7 @@ int
 getcmd(char *buf, int nbuf)
 {
   write(2, "$ ", 2);
-  memset(buf, 0, nbuf);
-  gets(buf, nbuf);
-  if(buf[0] == 0) // EOF
+  if(readline(0, buf, nbuf) <= 0) // EOF
     return -1;
   return 0;
 }
@@ -169,6 +167,10 @@ main(void)
       if(chdir(cmd+3) < 0)
         fprintf(2, "cannot cd %s\n", cmd+3);
     } else {
+      // A script file was read ahead; hand the rest back so the
+      // command reads on from the next line. The console and
+      // init's O_LINES pipe never give more than a line per read.
+      readline_unread(0);
       if(fork1() == 0)
         runcmd(parsecmd(cmd));
       wait(0);
@@ -0,0 +1,131 @@
+// user/sysstat.c
+// Print per-system-call counts and time (in r_time() units,
+// about 10 per microsecond under qemu).
+//
+// Usage:
+//   sysstat              // system-wide totals since boot
+//   sysstat <pid>        // one live process
+//   sysstat <cmd> [args] // run cmd and show the system-wide
+//                        // delta while it ran
+//
+// Example:
+//   sysstat iobound 40 1 2
+//     // shows write() dominating, one call per printed byte.
+
+#include "kernel/types.h"
+#include "kernel/stat.h"
+#include "kernel/syscall.h"
+#include "kernel/sysstat.h"
+#include "user/user.h"
+
+static char *names[NSYSCALL] = {
+[SYS_fork]           = "fork",
+[SYS_exit]           = "exit",
+[SYS_wait]           = "wait",
+[SYS_pipe]           = "pipe",
+[SYS_read]           = "read",
+[SYS_kill]           = "kill",
+[SYS_exec]           = "exec",
+[SYS_fstat]          = "fstat",
+[SYS_chdir]          = "chdir",
+[SYS_dup]            = "dup",
+[SYS_getpid]         = "getpid",
+[SYS_sbrk]           = "sbrk",
+[SYS_pause]          = "pause",
+[SYS_uptime]         = "uptime",
+[SYS_open]           = "open",
+[SYS_write]          = "write",
+[SYS_mknod]          = "mknod",
+[SYS_unlink]         = "unlink",
+[SYS_link]           = "link",
+[SYS_mkdir]          = "mkdir",
+[SYS_close]          = "close",
+[SYS_set_llm_advice] = "set_llm_advice",
+[SYS_uring_setup]    = "uring_setup",
+[SYS_uring_enter]    = "uring_enter",
+[SYS_getsysstat]     = "getsysstat",
+[SYS_clone]          = "clone",
+[SYS_futex]          = "futex",
+[SYS_setaffinity]    = "setaffinity",
+[SYS_setrealtime]    = "setrealtime",
+[SYS_setschedgroup]  = "setschedgroup",
+[SYS_getpriority]    = "getpriority",
+[SYS_setpriority]    = "setpriority",
+[SYS_setschedpolicy] = "setschedpolicy",
+[SYS_settimeslice]   = "settimeslice",
+[SYS_setgang]        = "setgang",
+[SYS_setstarvebound] = "setstarvebound",
+[SYS_yield]          = "yield",
+[SYS_lseek]          = "lseek",
+[SYS_pipe2]          = "pipe2",
+};
+
+static struct sysstat before, after;
+
+static int
+isnumber(char *s)
+{
+  if(*s == 0)
+    return 0;
+  for(; *s; s++)
+    if(*s < '0' || *s > '9')
+      return 0;
+  return 1;
+}
+
+// Print one line per syscall that was called at least once.
+static void
+show(struct sysstat *st)
+{
+  uint64 calls = 0, time = 0;
+
+  for(int i = 0; i < NSYSCALL; i++){
+    if(st->count[i] == 0)
+      continue;
+    printf("%s: count=%lu time=%lu avg=%lu\n",
+           names[i] ? names[i] : "?",
+           st->count[i], st->time[i], st->time[i] / st->count[i]);
+    calls += st->count[i];
+    time += st->time[i];
+  }
+  printf("total: count=%lu time=%lu\n", calls, time);
+  if(st->logcommits)
+    printf("log: commits=%lu blocks=%lu\n", st->logcommits, st->logblocks);
+}
+
+int
+main(int argc, char *argv[])
+{
+  if(argc < 2 || isnumber(argv[1])){
+    int pid = argc < 2 ? 0 : atoi(argv[1]);
+    if(getsysstat(pid, &after) < 0){
+      fprintf(2, "sysstat: no process %d\n", pid);
+      exit(1);
+    }
+    show(&after);
+    exit(0);
+  }
+
+  getsysstat(0, &before);
+  int pid = fork();
+  if(pid < 0){
+    fprintf(2, "sysstat: fork failed\n");
+    exit(1);
+  }
+  if(pid == 0){
+    exec(argv[1], argv + 1);
+    fprintf(2, "sysstat: exec %s failed\n", argv[1]);
+    exit(1);
+  }
+  wait(0);
+  getsysstat(0, &after);
+
+  for(int i = 0; i < NSYSCALL; i++){
+    after.count[i] -= before.count[i];
+    after.time[i] -= before.time[i];
+  }
+  after.logcommits -= before.logcommits;
+  after.logblocks -= before.logblocks;
+  show(&after);
+  exit(0);
+}
@@ -0,0 +1,48 @@
+// user/taskset.c
+// Run a command, or move an existing process, on a subset of CPUs.
+//
+// Usage:
+//   taskset <mask> <cmd> [args...]   run cmd restricted to mask
+//   taskset -p <mask> <pid>          restrict a running process
+//
+// mask is a decimal bitmask of harts: 1 = hart 0, 2 = hart 1,
+// 3 = harts 0 and 1, and so on. The mask is inherited by children.
+
+#include "kernel/types.h"
+#include "kernel/stat.h"
+#include "user/user.h"
+
+static void
+usage(void)
+{
+  fprintf(2, "usage: taskset <mask> <cmd> [args...]\n"
+             "       taskset -p <mask> <pid>\n");
+  exit(1);
+}
+
+int
+main(int argc, char *argv[])
+{
+  int old;
+
+  if(argc >= 2 && strcmp(argv[1], "-p") == 0){
+    if(argc != 4)
+      usage();
+    if((old = setaffinity(atoi(argv[3]), atoi(argv[2]))) < 0){
+      fprintf(2, "taskset: cannot set affinity of pid %s\n", argv[3]);
+      exit(1);
+    }
+    printf("pid %s: mask %d -> %d\n", argv[3], old, atoi(argv[2]));
+    exit(0);
+  }
+
+  if(argc < 3)
+    usage();
+  if(setaffinity(0, atoi(argv[1])) < 0){
+    fprintf(2, "taskset: bad mask %s\n", argv[1]);
+    exit(1);
+  }
+  exec(argv[2], argv + 2);
+  fprintf(2, "taskset: exec %s failed\n", argv[2]);
+  exit(1);
+}
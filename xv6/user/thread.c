@@ -0,0 +1,99 @@
+// Threads on top of clone() and futex().
+//
+// Threads share memory and open files with the process that
+// created them. exit() from a thread ends only that thread;
+// exit() from the main thread (or returning from main) kills
+// and reaps any threads still running first. getpid() names
+// the process, thread_self() the calling thread.
+//
+// malloc() is not thread-safe, so call thread_create() and
+// thread_join() (and malloc/free) from one thread at a time,
+// or under a mutex.
+
+#include "kernel/types.h"
+#include "kernel/futex.h"
+#include "user/user.h"
+
+#define THREAD_STACK  (4*4096)
+
+static void
+thread_start(void *arg)
+{
+  struct thread *t = arg;
+
+  t->fn(t->arg);
+  exit(0);
+}
+
+// Start fn(arg) in a new thread described by t.
+// Returns 0, or -1 if out of memory or threads.
+int
+thread_create(struct thread *t, void (*fn)(void*), void *arg)
+{
+  if((t->stack = malloc(THREAD_STACK)) == 0)
+    return -1;
+  t->fn = fn;
+  t->arg = arg;
+  if(clone(thread_start, t, (char*)t->stack + THREAD_STACK, &t->tid) < 0){
+    free(t->stack);
+    t->stack = 0;
+    return -1;
+  }
+  return 0;
+}
+
+// Wait for t to exit, then free its stack. The kernel
+// clears t->tid and wakes us when the thread is gone.
+int
+thread_join(struct thread *t)
+{
+  int tid;
+
+  if(t->stack == 0)
+    return -1;
+  while((tid = *(volatile int*)&t->tid) != 0)
+    futex(&t->tid, FUTEX_WAIT, tid);
+  free(t->stack);
+  t->stack = 0;
+  return 0;
+}
+
+int
+thread_self(void)
+{
+  return sys_getpid();
+}
+
+// A mutex is 0 when unlocked, 1 when locked, and 2 when
+// locked with (possibly) sleeping waiters, so an uncontended
+// lock and unlock never enter the kernel.
+
+void
+mutex_init(struct mutex *m)
+{
+  m->state = 0;
+}
+
+void
+mutex_lock(struct mutex *m)
+{
+  int c;
+
+  if((c = __sync_val_compare_and_swap(&m->state, 0, 1)) == 0)
+    return;
+  if(c != 2)
+    c = __sync_lock_test_and_set(&m->state, 2);
+  while(c != 0){
+    futex(&m->state, FUTEX_WAIT, 2);
+    c = __sync_lock_test_and_set(&m->state, 2);
+  }
+}
+
+void
+mutex_unlock(struct mutex *m)
+{
+  if(__sync_fetch_and_sub(&m->state, 1) != 1){
+    __sync_lock_release(&m->state);
+    futex(&m->state, FUTEX_WAKE, 1);
+  }
+}
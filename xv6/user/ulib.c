@@ -1,7 +1,9 @@
 #include "kernel/types.h"
 #include "kernel/stat.h"
 #include "kernel/fcntl.h"
+#include "kernel/param.h"
 #include "kernel/riscv.h"
+#include "kernel/memlayout.h"
 #include "kernel/vm.h"
 #include "user/user.h"
 
@@ -36,27 +38,6 @@ strcmp(const char *p, const char *q)
   return (uchar)*p - (uchar)*q;
 }
 
-uint
-strlen(const char *s)
-{
-  int n;
-
-  for(n = 0; s[n]; n++)
-    ;
-  return n;
-}
-
-void*
-memset(void *dst, int c, uint n)
-{
-  char *cdst = (char *) dst;
-  int i;
-  for(i = 0; i < n; i++){
-    cdst[i] = c;
-  }
-  return dst;
-}
-
 char*
 strchr(const char *s, char c)
 {
@@ -66,21 +47,100 @@ strchr(const char *s, char c)
   return 0;
 }
 
-char*
-gets(char *buf, int max)
+// Buffered input: one read buffer per file descriptor, so that
+// reading a line costs a read() per RLBUF bytes rather than per
+// byte. Whatever a buffer holds past the line returned belongs to
+// this process only: a child exec()ed on the same fd won't see it
+// (unless readline_unread() gives it back first), and plain read()s
+// on the fd skip it. The console, and pipes made with pipe2()'s
+// O_LINES, return at most a line per read(), so from them nothing
+// is read ahead.
+//
+// A buffer is only allocated the first time readline() is used on
+// its fd, from sbrk() rather than malloc() so that programs linked
+// without umalloc.o (forktest) still link.
+#define RLBUF 512               // a full pipe
+
+struct rlbuf {
+  char buf[RLBUF];
+  int r;                        // next byte to hand out
+  int n;                        // bytes in buf
+};
+
+static struct rlbuf *rl[NOFILE];
+
+// Read a line from fd into buf, newline included, stopping early
+// at max-1 bytes or end of file, and NUL-terminate it. Returns
+// the bytes stored (the line may itself contain NULs), 0 at end
+// of file, or -1 on error.
+int
+readline(int fd, char *buf, int max)
 {
-  int i, cc;
+  struct rlbuf *b;
+  int i = 0, n;
   char c;
 
-  for(i=0; i+1 < max; ){
-    cc = read(0, &c, 1);
-    if(cc < 1)
-      break;
+  if(fd < 0 || fd >= NOFILE || max <= 0)
+    return -1;
+  if((b = rl[fd]) == 0){
+    if((b = (struct rlbuf*)sbrk(sizeof(struct rlbuf))) == (struct rlbuf*)-1)
+      return -1;
+    b->r = b->n = 0;
+    rl[fd] = b;
+  }
+  while(i + 1 < max){
+    if(b->r == b->n){
+      n = read(fd, b->buf, RLBUF);
+      if(n <= 0){
+        b->r = b->n = 0;
+        if(n < 0 && i == 0){
+          buf[0] = 0;
+          return -1;
+        }
+        break;
+      }
+      b->r = 0;
+      b->n = n;
+    }
+    c = b->buf[b->r++];
     buf[i++] = c;
-    if(c == '\n' || c == '\r')
+    if(c == '\n')
       break;
   }
-  buf[i] = '\0';
+  buf[i] = 0;
+  return i;
+}
+
+// Forget fd's buffered input, for a caller that closes fd before
+// reading it to the end and might reuse the number.
+void
+readline_drop(int fd)
+{
+  if(fd >= 0 && fd < NOFILE && rl[fd])
+    rl[fd]->r = rl[fd]->n = 0;
+}
+
+// Give fd's buffered input back by seeking fd back over it, so a
+// child that shares fd's offset (a command sh runs, say) reads on
+// from just after the last line returned. Returns 0, or -1 if fd
+// can't seek (a pipe or the console), leaving the input buffered.
+int
+readline_unread(int fd)
+{
+  struct rlbuf *b;
+
+  if(fd < 0 || fd >= NOFILE || (b = rl[fd]) == 0 || b->r == b->n)
+    return 0;
+  if(lseek(fd, b->r - b->n, SEEK_CUR) < 0)
+    return -1;
+  b->r = b->n = 0;
+  return 0;
+}
+
+char*
+gets(char *buf, int max)
+{
+  readline(0, buf, max);
   return buf;
 }
 
@@ -109,53 +169,47 @@ atoi(const char *s)
   return n;
 }
 
-void*
-memmove(void *vdst, const void *vsrc, int n)
-{
-  char *dst;
-  const char *src;
-
-  dst = vdst;
-  src = vsrc;
-  if (src > dst) {
-    while(n-- > 0)
-      *dst++ = *src++;
-  } else {
-    dst += n;
-    src += n;
-    while(n-- > 0)
-      *--dst = *--src;
-  }
-  return vdst;
+// memset, memmove, memcmp, memcpy and strlen come from
+// kernel/string.c, which the Makefile builds as user/string.o.
+
+char *
+sbrk(int n) {
+  return sys_sbrk(n, SBRK_EAGER);
+}
+
+char *
+sbrklazy(int n) {
+  return sys_sbrk(n, SBRK_LAZY);
 }
 
+
+// getpid() and uptime() read the kernel-maintained USYSCALL
+// page rather than making a system call.
 int
-memcmp(const void *s1, const void *s2, uint n)
+getpid(void)
 {
-  const char *p1 = s1, *p2 = s2;
-  while (n-- > 0) {
-    if (*p1 != *p2) {
-      return *p1 - *p2;
-    }
-    p1++;
-    p2++;
-  }
-  return 0;
+  return ((volatile struct usyscall *)USYSCALL)->pid;
 }
 
-void *
-memcpy(void *dst, const void *src, uint n)
+int
+uptime(void)
 {
-  return memmove(dst, src, n);
+  return ((volatile struct usyscall *)USYSCALL)->ticks;
 }
 
-char *
-sbrk(int n) {
-  return sys_sbrk(n, SBRK_EAGER);
+// The CPU the caller is running on, as of its last dispatch.
+int
+getcpu(void)
+{
+  return ((volatile struct usyscall *)USYSCALL)->cpu;
 }
 
-char *
-sbrklazy(int n) {
-  return sys_sbrk(n, SBRK_LAZY);
+// The time CSR, which counts TIMEBASE_HZ; finer than uptime()
+// for benchmarks.
+uint64
+rdtime(void)
+{
+  uint64 x;
+  asm volatile("rdtime %0" : "=r" (x));
+  return x;
 }
-
@@ -4,7 +4,16 @@
 #include "kernel/param.h"
 
 // Memory allocator by Kernighan and Ritchie,
-// The C programming Language, 2nd ed.  Section 8.7.
+// The C programming Language, 2nd ed.  Section 8.7,
+// with size classes in front of it for small objects.
+//
+// A request of up to 2K goes to the smallest size class that fits,
+// a power of two from 32 to 2048 bytes including the header. Each
+// class keeps its own free list, so malloc() and free() of small
+// objects just pop and push. An empty class is refilled with a
+// whole REFILL-byte chunk from sbrk(), carved into objects at once.
+// Freed small objects stay in their class. Larger requests use the
+// K&R first-fit list as before.
 
 typedef long Align;
 
@@ -21,12 +30,52 @@ typedef union header Header;
 static Header base;
 static Header *freep;
 
-void
-free(void *ap)
+// A small object's header has SMALL | class in s.size, which no
+// K&R block's unit count reaches, and s.ptr links its free list.
+#define SMALL    0x80000000
+#define NCLASS   7              // 32, 64, ..., 2048 bytes
+#define MINSHIFT 5
+#define REFILL   8192
+
+static Header *classfree[NCLASS];
+
+// The size class for nbytes of payload, or -1 if it's too big.
+static int
+sizeclass(uint nbytes)
+{
+  int c;
+
+  for(c = 0; c < NCLASS; c++)
+    if(nbytes + sizeof(Header) <= (1 << (c + MINSHIFT)))
+      return c;
+  return -1;
+}
+
+// Carve a fresh REFILL-byte chunk into objects of class c.
+static int
+refill(int c)
+{
+  uint sz = 1 << (c + MINSHIFT);
+  char *p, *end;
+  Header *hp;
+
+  p = sbrk(REFILL);
+  if(p == SBRK_ERROR)
+    return -1;
+  for(end = p + REFILL; p + sz <= end; p += sz){
+    hp = (Header*)p;
+    hp->s.size = SMALL | c;
+    hp->s.ptr = classfree[c];
+    classfree[c] = hp;
+  }
+  return 0;
+}
+
+static void
+kr_free(Header *bp)
 {
-  Header *bp, *p;
+  Header *p;
 
-  bp = (Header*)ap - 1;
   for(p = freep; !(bp > p && bp < p->s.ptr); p = p->s.ptr)
     if(p >= p->s.ptr && (bp > p || bp < p->s.ptr))
       break;
@@ -43,6 +92,20 @@ free(void *ap)
   freep = p;
 }
 
+void
+free(void *ap)
+{
+  Header *bp = (Header*)ap - 1;
+
+  if(bp->s.size & SMALL){
+    int c = bp->s.size & ~SMALL;
+    bp->s.ptr = classfree[c];
+    classfree[c] = bp;
+    return;
+  }
+  kr_free(bp);
+}
+
 static Header*
 morecore(uint nu)
 {
@@ -56,7 +119,7 @@ morecore(uint nu)
     return 0;
   hp = (Header*)p;
   hp->s.size = nu;
-  free((void*)(hp + 1));
+  kr_free(hp);
   return freep;
 }
 
@@ -65,6 +128,15 @@ malloc(uint nbytes)
 {
   Header *p, *prevp;
   uint nunits;
+  int c;
+
+  if((c = sizeclass(nbytes)) >= 0){
+    if(classfree[c] == 0 && refill(c) < 0)
+      return 0;
+    p = classfree[c];
+    classfree[c] = p->s.ptr;
+    return (void*)(p + 1);
+  }
 
   nunits = (nbytes + sizeof(Header) - 1)/sizeof(Header) + 1;
   if((prevp = freep) == 0){
@@ -1,6 +1,8 @@
 #define SBRK_ERROR ((char *)-1)
 
 struct stat;
+struct uring;
+struct sysstat;
 
 // system calls
 int fork(void);
@@ -20,29 +22,93 @@ int link(const char*, const char*);
 int mkdir(const char*);
 int chdir(const char*);
 int dup(int);
-int getpid(void);
+int sys_getpid(void);
 char* sys_sbrk(int, int);
 int pause(int);
-int uptime(void);
+int sys_uptime(void);
 
 // LLM scheduler integration: user wrapper for the set_llm_advice syscall.
 // llmhelper.c calls this to inject a recommended PID into the kernel.
 int set_llm_advice(int pid);
 
-// ulib.c
+// Batched syscall ring (kernel/uring.h).
+struct uring* uring_setup(void);
+int uring_enter(int n);
+
+// Per-syscall counts and time for pid, or system-wide if pid is 0.
+int getsysstat(int pid, struct sysstat *st);
+
+// Threads sharing this address space and open files.
+int clone(void (*fn)(void*), void *arg, void *stack, int *ctid);
+int futex(int *addr, int op, int val);
+
+// Restrict pid (0 = self) to the CPUs in mask; returns the old mask.
+int setaffinity(int pid, int mask);
+
+// Reserve runtime ticks every period ticks, due within deadline
+// ticks, in the EDF real-time class (pid 0 = self, runtime 0 = leave).
+int setrealtime(int pid, int runtime, int period, int deadline);
+
+// Move pid (0 = self, <0 = none) into scheduling group gid and,
+// if share > 0, set that group's CPU share (default 100).
+int setschedgroup(int pid, int gid, int share);
+
+// nice value of pid (0 = self): -20 (most important) .. 19.
+int getpriority(int pid, int *nice);
+int setpriority(int pid, int nice);
+
+// switch to scheduling policy id (SCHED_* in kernel/schedpolicy.h);
+// id < 0 just asks. Returns the previous policy.
+int setschedpolicy(int id);
+
+// quantum of pid (0 = self) in ticks, 0 = the policy's default;
+// pid -1 sets the current policy's default (ticks 0 just asks).
+// Returns the previous value.
+int settimeslice(int pid, int ticks);
+
+// move pid (0 = self) into gang id (0 = none), inherited by fork();
+// harts run a gang's members side by side. Returns the previous gang.
+int setgang(int pid, int id);
+
+// run any process RUNNABLE for ticks (0 = off) ahead of advice and
+// policy; ticks < 0 just asks. Returns the previous bound.
+int setstarvebound(int ticks);
+
+// give up the CPU to any other runnable process.
+int yield(void);
+
+// set fd's offset to off from SEEK_SET/SEEK_CUR/SEEK_END; it may
+// not pass the end of the file. Returns the new offset or -1.
+int lseek(int fd, int off, int whence);
+
+// pipe() with flags: O_LINES makes each read() return at most
+// one line.
+int pipe2(int fds[2], int flags);
+
+// ulib.c; mem*() and strlen() are kernel/string.c
 int   stat(const char*, struct stat*);
 char* strcpy(char*, const char*);
-void* memmove(void*, const void*, int);
+void* memmove(void*, const void*, uint);
 char* strchr(const char*, char c);
 int   strcmp(const char*, const char*);
 char* gets(char*, int max);
-uint  strlen(const char*);
+int   readline(int fd, char*, int max);
+void  readline_drop(int fd);
+int   readline_unread(int fd);
+int   strlen(const char*);
 void* memset(void*, int, uint);
 int   atoi(const char*);
 int   memcmp(const void *, const void *, uint);
 void* memcpy(void *, const void *, uint);
 char* sbrk(int);
 char* sbrklazy(int);
+int   getpid(void);
+int   uptime(void);
+int   getcpu(void);
+uint64 rdtime(void);
+
+// rdtime() counts at this rate on qemu's virt machine.
+#define TIMEBASE_HZ 10000000
 
 // printf.c
 void fprintf(int, const char*, ...) __attribute__ ((format (printf, 2, 3)));
@@ -51,3 +117,20 @@ void printf(const char*, ...) __attribute__ ((format (printf, 1, 2)));
 // umalloc.c
 void* malloc(uint);
 void  free(void*);
+
+// thread.c
+struct thread {
+  int tid;              // thread's pid; 0 once it has exited
+  void *stack;
+  void (*fn)(void*);
+  void *arg;
+};
+struct mutex {
+  int state;
+};
+int   thread_create(struct thread*, void (*)(void*), void*);
+int   thread_join(struct thread*);
+int   thread_self(void);
+void  mutex_init(struct mutex*);
+void  mutex_lock(struct mutex*);
+void  mutex_unlock(struct mutex*);
@@ -7,14 +7,17 @@
 #include "kernel/syscall.h"
 #include "kernel/memlayout.h"
 #include "kernel/riscv.h"
+#include "kernel/uring.h"
 
 //
 // Tests xv6 system calls.  usertests without arguments runs them all
 // and usertests <name> runs <name> test. The test runner creates for
 // each test a process and based on the exit status of the process,
-// the test runner reports "OK" or "FAILED".  Some tests result in
-// kernel printing usertrap messages, which can be ignored if test
-// prints "OK".
+// the test runner reports "OK" or "FAILED", with the test's wall
+// time.  Some tests result in kernel printing usertrap messages,
+// which can be ignored if test prints "OK".  usertests -p n runs up
+// to n tests at a time, each in its own directory, then the ones
+// that need the machine to themselves.
 //
 
 #define BUFSZ  ((MAXOPBLOCKS+2)*BSIZE)
@@ -2429,14 +2432,14 @@ stacktest(char *s)
 }
 
 // check that writes to a few forbidden addresses
-// cause a fault, e.g. process's text and TRAMPOLINE.
+// cause a fault, e.g. process's text, USYSCALL and TRAMPOLINE.
 void
 nowrite(char *s)
 {
   int pid;
   int xstatus;
-  uint64 addrs[] = { 0, 0x80000000LL, 0x3fffffe000, 0x3ffffff000, 0x4000000000,
-                     0xffffffffffffffff };
+  uint64 addrs[] = { 0, 0x80000000LL, 0x3fffffd000, 0x3fffffe000, 0x3ffffff000,
+                     0x4000000000, 0xffffffffffffffff };
   
   for(int ai = 0; ai < sizeof(addrs)/sizeof(addrs[0]); ai++){
     pid = fork();
@@ -2458,6 +2461,564 @@ nowrite(char *s)
   exit(0);
 }
 
+// does the USYSCALL page agree with the real system calls,
+// in both parent and a forked child?
+void
+usyscall(char *s)
+{
+  int pid, xstatus;
+
+  if(getpid() != sys_getpid()){
+    printf("%s: getpid %d != sys_getpid %d\n", s, getpid(), sys_getpid());
+    exit(1);
+  }
+
+  pid = fork();
+  if(pid < 0){
+    printf("%s: fork failed\n", s);
+    exit(1);
+  }
+  if(pid == 0){
+    if(getpid() != sys_getpid()){
+      printf("%s: child getpid %d != sys_getpid %d\n", s, getpid(), sys_getpid());
+      exit(1);
+    }
+    exit(0);
+  }
+  wait(&xstatus);
+  if(xstatus != 0)
+    exit(1);
+
+  // the page is refreshed every tick, so it may lag by one.
+  int t0 = uptime();
+  int t1 = sys_uptime();
+  if(t1 - t0 < 0 || t1 - t0 > 1){
+    printf("%s: uptime %d vs sys_uptime %d\n", s, t0, t1);
+    exit(1);
+  }
+  pause(2);
+  if(uptime() <= t0){
+    printf("%s: uptime did not advance\n", s);
+    exit(1);
+  }
+}
+
+// batched write/read through the uring, and a bad fd
+// completing with -1 rather than failing the whole batch.
+void
+uringtest(char *s)
+{
+  struct uring *r;
+  int fds[2], pid, xstatus;
+  char out[4] = "abc", in[4];
+
+  if((r = uring_setup()) == (struct uring *)-1){
+    printf("%s: uring_setup failed\n", s);
+    exit(1);
+  }
+  if(pipe(fds) < 0){
+    printf("%s: pipe failed\n", s);
+    exit(1);
+  }
+
+  struct uring_sqe *sqe = &r->sq[0];
+  sqe->op = URING_OP_WRITE; sqe->fd = fds[1]; sqe->addr = (uint64)out; sqe->len = 3; sqe->user_data = 1;
+  sqe = &r->sq[1];
+  sqe->op = URING_OP_READ; sqe->fd = fds[0]; sqe->addr = (uint64)in; sqe->len = 3; sqe->user_data = 2;
+  sqe = &r->sq[2];
+  sqe->op = URING_OP_WRITE; sqe->fd = NOFILE; sqe->addr = (uint64)out; sqe->len = 3; sqe->user_data = 3;
+  r->sq_tail = 3;
+
+  if(uring_enter(3) != 3 || r->cq_tail != 3){
+    printf("%s: uring_enter did not run 3 ops\n", s);
+    exit(1);
+  }
+  if(r->cq[0].user_data != 1 || r->cq[0].res != 3 ||
+     r->cq[1].user_data != 2 || r->cq[1].res != 3 ||
+     r->cq[2].user_data != 3 || r->cq[2].res != -1){
+    printf("%s: wrong completions\n", s);
+    exit(1);
+  }
+  if(memcmp(in, out, 3) != 0){
+    printf("%s: read back wrong data\n", s);
+    exit(1);
+  }
+
+  // the ring is not inherited; touching it in a child must fault.
+  pid = fork();
+  if(pid < 0){
+    printf("%s: fork failed\n", s);
+    exit(1);
+  }
+  if(pid == 0){
+    ((volatile struct uring *)URING)->sq_tail = 0;
+    exit(0);
+  }
+  wait(&xstatus);
+  if(xstatus != -1){
+    printf("%s: child could use parent's ring\n", s);
+    exit(1);
+  }
+}
+
+static struct mutex clone_mu;
+static int clone_count;
+static char *clone_mem;
+
+static void
+clone_worker(void *arg)
+{
+  for(int i = 0; i < 1000; i++){
+    mutex_lock(&clone_mu);
+    clone_count++;
+    mutex_unlock(&clone_mu);
+  }
+  if(arg)
+    clone_mem = sbrk(PGSIZE);
+}
+
+static void
+clone_spin(void *arg)
+{
+  for(;;)
+    ;
+}
+
+// threads share memory and are joined through the ctid futex;
+// memory grown by one thread is visible to the others; and
+// exiting the main thread takes running threads with it.
+void
+clonetest(char *s)
+{
+  struct thread t[4];
+  int i, pid, xstatus;
+
+  mutex_init(&clone_mu);
+  for(i = 0; i < 4; i++){
+    if(thread_create(&t[i], clone_worker, i == 0 ? (void*)1 : 0) < 0){
+      printf("%s: thread_create failed\n", s);
+      exit(1);
+    }
+  }
+  for(i = 0; i < 4; i++){
+    if(thread_join(&t[i]) < 0 || t[i].tid != 0){
+      printf("%s: thread_join failed\n", s);
+      exit(1);
+    }
+  }
+  if(clone_count != 4000){
+    printf("%s: count %d, not 4000\n", s, clone_count);
+    exit(1);
+  }
+  if(clone_mem == SBRK_ERROR || clone_mem == 0){
+    printf("%s: sbrk in thread failed\n", s);
+    exit(1);
+  }
+  clone_mem[PGSIZE-1] = 'x';
+
+  pid = fork();
+  if(pid < 0){
+    printf("%s: fork failed\n", s);
+    exit(1);
+  }
+  if(pid == 0){
+    if(thread_create(&t[0], clone_spin, 0) < 0)
+      exit(1);
+    exit(0);
+  }
+  wait(&xstatus);
+  if(xstatus != 0){
+    printf("%s: thread_create in child failed\n", s);
+    exit(1);
+  }
+}
+
+// setaffinity() refuses masks with no online CPU and unknown
+// pids, returns the old mask, moves the caller onto an allowed
+// CPU at once, and is inherited across fork().
+void
+affinitytest(char *s)
+{
+  int i, r, all, online, prev, pid, xstatus;
+
+  all = (1 << NCPU) - 1;
+  if(setaffinity(0, 0) != -1){
+    printf("%s: empty mask accepted\n", s);
+    exit(1);
+  }
+  setaffinity(0, all);
+
+  // a single-CPU mask is refused exactly when that CPU is offline.
+  online = 0;
+  prev = all;
+  for(i = 0; i < NCPU; i++){
+    if((r = setaffinity(0, 1 << i)) == -1)
+      continue;
+    if(r != prev){
+      printf("%s: old mask %x, not %x\n", s, r, prev);
+      exit(1);
+    }
+    if(getcpu() != i){
+      printf("%s: on cpu %d, not %d\n", s, getcpu(), i);
+      exit(1);
+    }
+    online |= 1 << i;
+    prev = 1 << i;
+  }
+  if(online == 0){
+    printf("%s: no CPU accepted\n", s);
+    exit(1);
+  }
+  if(online != all && setaffinity(0, all & ~online) != -1){
+    printf("%s: offline mask accepted\n", s);
+    exit(1);
+  }
+
+  pid = fork();
+  if(pid < 0){
+    printf("%s: fork failed\n", s);
+    exit(1);
+  }
+  if(pid == 0){
+    if(((1 << getcpu()) & prev) == 0)
+      exit(1);
+    exit(setaffinity(0, all) == prev ? 0 : 1);
+  }
+  wait(&xstatus);
+  if(xstatus != 0){
+    printf("%s: mask not inherited\n", s);
+    exit(1);
+  }
+  if(setaffinity(pid, all) != -1){
+    printf("%s: exited pid accepted\n", s);
+    exit(1);
+  }
+  setaffinity(0, all);
+}
+
+// setrealtime() refuses inconsistent parameters, unknown pids,
+// and reservations that would overcommit, even ones large enough
+// to overflow a naive utilization sum.
+void
+realtimetest(char *s)
+{
+  int pid, xstatus;
+
+  if(setrealtime(0, -1, 10, 10) != -1 ||
+     setrealtime(0, 5, 10, 4) != -1 ||
+     setrealtime(0, 2, 4, 5) != -1){
+    printf("%s: inconsistent reservation accepted\n", s);
+    exit(1);
+  }
+  if(setrealtime(0, 10, 10, 10) != -1 ||
+     setrealtime(0, 3000000, 3000000, 3000000) != -1){
+    printf("%s: overcommitted reservation accepted\n", s);
+    exit(1);
+  }
+  if(setrealtime(0, 1, 10, 10) != 0){
+    printf("%s: reservation refused\n", s);
+    exit(1);
+  }
+  if(setrealtime(0, 0, 0, 0) != 0){
+    printf("%s: clearing the reservation failed\n", s);
+    exit(1);
+  }
+
+  pid = fork();
+  if(pid < 0){
+    printf("%s: fork failed\n", s);
+    exit(1);
+  }
+  if(pid == 0)
+    exit(0);
+  wait(&xstatus);
+  if(setrealtime(pid, 1, 10, 10) != -1){
+    printf("%s: exited pid accepted\n", s);
+    exit(1);
+  }
+}
+
+// setschedgroup() refuses out-of-range groups and shares and
+// unknown pids.
+void
+schedgrouptest(char *s)
+{
+  int pid, xstatus;
+
+  if(setschedgroup(0, -1, 0) != -1 || setschedgroup(0, NSGROUP, 0) != -1){
+    printf("%s: bad group accepted\n", s);
+    exit(1);
+  }
+  if(setschedgroup(-1, 0, 1000000) != -1){
+    printf("%s: bad share accepted\n", s);
+    exit(1);
+  }
+  if(setschedgroup(0, NSGROUP-1, 0) != 0 || setschedgroup(0, 0, 0) != 0){
+    printf("%s: moving between groups failed\n", s);
+    exit(1);
+  }
+
+  pid = fork();
+  if(pid < 0){
+    printf("%s: fork failed\n", s);
+    exit(1);
+  }
+  if(pid == 0)
+    exit(0);
+  wait(&xstatus);
+  if(setschedgroup(pid, 0, 0) != -1){
+    printf("%s: exited pid accepted\n", s);
+    exit(1);
+  }
+}
+
+// setpriority() clamps nice to -20..19, fork() inherits it, and
+// both calls refuse unknown pids.
+void
+prioritytest(char *s)
+{
+  int nice, pid, xstatus;
+
+  if(setpriority(0, 5) != 0 || getpriority(0, &nice) != 0 || nice != 5){
+    printf("%s: nice 5 not set\n", s);
+    exit(1);
+  }
+  setpriority(0, 100);
+  if(getpriority(0, &nice) != 0 || nice != 19){
+    printf("%s: nice 100 gave %d, not 19\n", s, nice);
+    exit(1);
+  }
+  setpriority(0, -100);
+  if(getpriority(0, &nice) != 0 || nice != -20){
+    printf("%s: nice -100 gave %d, not -20\n", s, nice);
+    exit(1);
+  }
+
+  pid = fork();
+  if(pid < 0){
+    printf("%s: fork failed\n", s);
+    exit(1);
+  }
+  if(pid == 0)
+    exit(getpriority(0, &nice) == 0 && nice == -20 ? 0 : 1);
+  wait(&xstatus);
+  if(xstatus != 0){
+    printf("%s: nice not inherited\n", s);
+    exit(1);
+  }
+  if(getpriority(pid, &nice) != -1 || setpriority(pid, 0) != -1){
+    printf("%s: exited pid accepted\n", s);
+    exit(1);
+  }
+  setpriority(0, 0);
+}
+
+// settimeslice() refuses out-of-range slices and unknown pids,
+// returns the previous slice, is inherited across fork(), and
+// with pid -1 and 0 ticks only reports the policy's default.
+void
+timeslicetest(char *s)
+{
+  int slice, pid, xstatus;
+
+  if(settimeslice(0, -1) != -1 || settimeslice(0, 1000000) != -1){
+    printf("%s: bad slice accepted\n", s);
+    exit(1);
+  }
+  if(settimeslice(0, 5) != 0 || settimeslice(0, 0) != 5){
+    printf("%s: old slice not returned\n", s);
+    exit(1);
+  }
+  if((slice = settimeslice(-1, 0)) <= 0 || settimeslice(-1, 0) != slice){
+    printf("%s: policy slice %d\n", s, slice);
+    exit(1);
+  }
+
+  settimeslice(0, 7);
+  pid = fork();
+  if(pid < 0){
+    printf("%s: fork failed\n", s);
+    exit(1);
+  }
+  if(pid == 0)
+    exit(settimeslice(0, 0) == 7 ? 0 : 1);
+  wait(&xstatus);
+  settimeslice(0, 0);
+  if(xstatus != 0){
+    printf("%s: slice not inherited\n", s);
+    exit(1);
+  }
+  if(settimeslice(pid, 5) != -1){
+    printf("%s: exited pid accepted\n", s);
+    exit(1);
+  }
+}
+
+// setgang() refuses negative ids and unknown pids, returns the
+// previous gang, and is inherited across fork().
+void
+gangtest(char *s)
+{
+  int pid, xstatus;
+
+  if(setgang(0, -1) != -1){
+    printf("%s: negative gang accepted\n", s);
+    exit(1);
+  }
+  if(setgang(0, 4242) != 0 || setgang(0, 4243) != 4242){
+    printf("%s: old gang not returned\n", s);
+    exit(1);
+  }
+
+  pid = fork();
+  if(pid < 0){
+    printf("%s: fork failed\n", s);
+    exit(1);
+  }
+  if(pid == 0)
+    exit(setgang(0, 0) == 4243 ? 0 : 1);
+  wait(&xstatus);
+  if(xstatus != 0){
+    printf("%s: gang not inherited\n", s);
+    exit(1);
+  }
+  if(setgang(pid, 4242) != -1){
+    printf("%s: exited pid accepted\n", s);
+    exit(1);
+  }
+  if(setgang(0, 0) != 4243){
+    printf("%s: leaving the gang failed\n", s);
+    exit(1);
+  }
+}
+
+// setstarvebound() returns the previous bound, and a negative
+// bound only reports it.
+void
+starvetest(char *s)
+{
+  int old;
+
+  if((old = setstarvebound(-1)) < 0 || setstarvebound(-1) != old){
+    printf("%s: bound %d\n", s, old);
+    exit(1);
+  }
+  if(setstarvebound(old + 5) != old || setstarvebound(-1) != old + 5){
+    printf("%s: bound not set\n", s);
+    exit(1);
+  }
+  if(setstarvebound(old) != old + 5){
+    printf("%s: old bound not returned\n", s);
+    exit(1);
+  }
+}
+
+// lseek() moves the offset with SEEK_SET, SEEK_CUR and SEEK_END,
+// refuses offsets before the start or past the end of the file
+// and anything but files, and reads and writes then use the new
+// offset.
+void
+lseektest(char *s)
+{
+  int fd, fds[2];
+  char buf[8];
+
+  unlink("lseekfile");
+  fd = open("lseekfile", O_CREATE|O_RDWR);
+  if(fd < 0){
+    printf("%s: create lseekfile failed\n", s);
+    exit(1);
+  }
+  if(write(fd, "abcdefghij", 10) != 10){
+    printf("%s: write failed\n", s);
+    exit(1);
+  }
+  if(lseek(fd, 2, SEEK_SET) != 2 || read(fd, buf, 3) != 3 ||
+     memcmp(buf, "cde", 3) != 0){
+    printf("%s: SEEK_SET failed\n", s);
+    exit(1);
+  }
+  if(lseek(fd, 1, SEEK_CUR) != 6 || read(fd, buf, 1) != 1 || buf[0] != 'g'){
+    printf("%s: SEEK_CUR failed\n", s);
+    exit(1);
+  }
+  if(lseek(fd, -2, SEEK_END) != 8 || read(fd, buf, sizeof(buf)) != 2 ||
+     memcmp(buf, "ij", 2) != 0){
+    printf("%s: SEEK_END failed\n", s);
+    exit(1);
+  }
+
+  if(lseek(fd, -1, SEEK_SET) != -1 || lseek(fd, -11, SEEK_END) != -1 ||
+     lseek(fd, -11, SEEK_CUR) != -1){
+    printf("%s: negative offset accepted\n", s);
+    exit(1);
+  }
+  if(lseek(fd, 11, SEEK_SET) != -1 || lseek(fd, 1, SEEK_END) != -1 ||
+     lseek(fd, 0, 3) != -1){
+    printf("%s: offset past EOF accepted\n", s);
+    exit(1);
+  }
+  if(lseek(fd, 0, SEEK_CUR) != 10){
+    printf("%s: refused seek moved the offset\n", s);
+    exit(1);
+  }
+
+  if(lseek(fd, 4, SEEK_SET) != 4 || write(fd, "XY", 2) != 2 ||
+     lseek(fd, 0, SEEK_SET) != 0 || read(fd, buf, 8) != 8 ||
+     memcmp(buf, "abcdXYgh", 8) != 0){
+    printf("%s: write after seek failed\n", s);
+    exit(1);
+  }
+  close(fd);
+  unlink("lseekfile");
+
+  if(pipe(fds) < 0){
+    printf("%s: pipe failed\n", s);
+    exit(1);
+  }
+  if(lseek(fds[0], 0, SEEK_SET) != -1 || lseek(fds[1], 0, SEEK_CUR) != -1){
+    printf("%s: lseek on a pipe succeeded\n", s);
+    exit(1);
+  }
+  close(fds[0]);
+  close(fds[1]);
+}
+
+// pipe2() refuses unknown flags, and with O_LINES each read()
+// stops after a newline, while a read of an unterminated tail
+// returns what there is.
+void
+pipe2test(char *s)
+{
+  int fds[2];
+  char buf[16];
+
+  if(pipe2(fds, 0x1) != -1){
+    printf("%s: unknown flag accepted\n", s);
+    exit(1);
+  }
+  if(pipe2(fds, O_LINES) < 0){
+    printf("%s: pipe2 failed\n", s);
+    exit(1);
+  }
+  if(write(fds[1], "ab\ncd\nef", 8) != 8){
+    printf("%s: write failed\n", s);
+    exit(1);
+  }
+  if(read(fds[0], buf, sizeof(buf)) != 3 || memcmp(buf, "ab\n", 3) != 0 ||
+     read(fds[0], buf, sizeof(buf)) != 3 || memcmp(buf, "cd\n", 3) != 0 ||
+     read(fds[0], buf, sizeof(buf)) != 2 || memcmp(buf, "ef", 2) != 0){
+    printf("%s: reads did not stop at newlines\n", s);
+    exit(1);
+  }
+  close(fds[1]);
+  if(read(fds[0], buf, sizeof(buf)) != 0){
+    printf("%s: no EOF\n", s);
+    exit(1);
+  }
+  close(fds[0]);
+}
+
 // regression test. copyin(), copyout(), and copyinstr() used to cast
 // the virtual page address to uint, which (with certain wild system
 // call arguments) resulted in a kernel page faults.
@@ -2713,7 +3274,7 @@ lazy_sbrk(char *s)
     p = sbrklazy(0);
   }
 
-  int n = TRAPFRAME-PGSIZE-(uint64)p;
+  int n = USERTOP-PGSIZE-(uint64)p;
 
   char *p1 = sbrklazy(n);
   if (p1 < 0 || p1 != p) {
@@ -2722,8 +3283,8 @@ lazy_sbrk(char *s)
   }
 
   p = sbrk(PGSIZE);
-  if (p < 0 || (uint64)p != TRAPFRAME-PGSIZE) {
-    printf("sbrk(%d) returned %p, not expected TRAPFRAME-PGSIZE\n", PGSIZE, p);
+  if (p < 0 || (uint64)p != USERTOP-PGSIZE) {
+    printf("sbrk(%d) returned %p, not expected USERTOP-PGSIZE\n", PGSIZE, p);
     exit(1);
   }
 
@@ -2748,73 +3309,91 @@ lazy_sbrk(char *s)
   exit(0);
 }
 
+// Tests marked SERIAL never run alongside others under -p: they
+// use files in / (README, echo, ...) rather than the cwd, use up
+// memory, processes or disk, or depend on timing.
+#define SERIAL 1
+
 struct test {
   void (*f)(char *);
   char *s;
+  int serial;
 } quicktests[] = {
   {copyin, "copyin"},
-  {copyout, "copyout"},
+  {copyout, "copyout", SERIAL},
   {copyinstr1, "copyinstr1"},
-  {copyinstr2, "copyinstr2"},
-  {copyinstr3, "copyinstr3"},
-  {rwsbrk, "rwsbrk" },
+  {copyinstr2, "copyinstr2", SERIAL},
+  {copyinstr3, "copyinstr3", SERIAL},
+  {rwsbrk, "rwsbrk", SERIAL},
   {truncate1, "truncate1"},
   {truncate2, "truncate2"},
   {truncate3, "truncate3"},
   {openiputtest, "openiput"},
   {exitiputtest, "exitiput"},
-  {iputtest, "iput"},
-  {opentest, "opentest"},
+  {iputtest, "iput", SERIAL},
+  {opentest, "opentest", SERIAL},
   {writetest, "writetest"},
   {writebig, "writebig"},
   {createtest, "createtest"},
   {dirtest, "dirtest"},
-  {exectest, "exectest"},
+  {exectest, "exectest", SERIAL},
   {pipe1, "pipe1"},
   {killstatus, "killstatus"},
-  {preempt, "preempt"},
+  {preempt, "preempt", SERIAL},
   {exitwait, "exitwait"},
   {reparent, "reparent" },
   {twochildren, "twochildren"},
   {forkfork, "forkfork"},
-  {forkforkfork, "forkforkfork"},
-  {reparent2, "reparent2"},
-  {mem, "mem"},
+  {forkforkfork, "forkforkfork", SERIAL},
+  {reparent2, "reparent2", SERIAL},
+  {mem, "mem", SERIAL},
   {sharedfd, "sharedfd"},
   {fourfiles, "fourfiles"},
   {createdelete, "createdelete"},
   {unlinkread, "unlinkread"},
   {linktest, "linktest"},
   {concreate, "concreate"},
-  {linkunlink, "linkunlink"},
-  {subdir, "subdir"},
+  {linkunlink, "linkunlink", SERIAL},
+  {subdir, "subdir", SERIAL},
   {bigwrite, "bigwrite"},
   {bigfile, "bigfile"},
   {fourteen, "fourteen"},
-  {rmdot, "rmdot"},
+  {rmdot, "rmdot", SERIAL},
   {dirfile, "dirfile"},
-  {iref, "iref"},
-  {forktest, "forktest"},
+  {iref, "iref", SERIAL},
+  {forktest, "forktest", SERIAL},
   {sbrkbasic, "sbrkbasic"},
-  {sbrkmuch, "sbrkmuch"},
+  {sbrkmuch, "sbrkmuch", SERIAL},
   {kernmem, "kernmem"},
   {MAXVAplus, "MAXVAplus"},
-  {sbrkfail, "sbrkfail"},
+  {sbrkfail, "sbrkfail", SERIAL},
   {sbrkarg, "sbrkarg"},
   {validatetest, "validatetest"},
   {bsstest, "bsstest"},
-  {bigargtest, "bigargtest"},
+  {bigargtest, "bigargtest", SERIAL},
   {argptest, "argptest"},
   {stacktest, "stacktest"},
   {nowrite, "nowrite"},
-  {pgbug, "pgbug" },
+  {usyscall, "usyscall"},
+  {uringtest, "uring"},
+  {clonetest, "clone"},
+  {affinitytest, "affinity"},
+  {realtimetest, "realtime"},
+  {schedgrouptest, "schedgroup"},
+  {prioritytest, "priority"},
+  {timeslicetest, "timeslice"},
+  {gangtest, "gang"},
+  {starvetest, "starve", SERIAL},
+  {lseektest, "lseek"},
+  {pipe2test, "pipe2"},
+  {pgbug, "pgbug", SERIAL},
   {sbrkbugs, "sbrkbugs" },
   {sbrklast, "sbrklast"},
-  {sbrk8000, "sbrk8000"},
-  {badarg, "badarg" },
+  {sbrk8000, "sbrk8000", SERIAL},
+  {badarg, "badarg", SERIAL},
   {lazy_alloc, "lazy_alloc"},
   {lazy_unmap, "lazy_unmap"},
-  {lazy_copy, "lazy_copy"},
+  {lazy_copy, "lazy_copy", SERIAL},
   {lazy_sbrk, "lazy_sbrk"},
   { 0, 0},
 };
@@ -3106,11 +3685,11 @@ outofinodes(char *s)
 
 struct test slowtests[] = {
   {bigdir, "bigdir"},
-  {manywrites, "manywrites"},
-  {badwrite, "badwrite" },
-  {execout, "execout"},
-  {diskfull, "diskfull"},
-  {outofinodes, "outofinodes"},
+  {manywrites, "manywrites", SERIAL},
+  {badwrite, "badwrite", SERIAL},
+  {execout, "execout", SERIAL},
+  {diskfull, "diskfull", SERIAL},
+  {outofinodes, "outofinodes", SERIAL},
     
   { 0, 0},
 };
@@ -3119,12 +3698,20 @@ struct test slowtests[] = {
 // drive tests
 //
 
+// wall time since t0, in ms.
+uint64
+msince(uint64 t0)
+{
+  return (rdtime() - t0) / (TIMEBASE_HZ / 1000);
+}
+
 // run each test in its own process. run returns 1 if child's exit()
 // indicates success.
 int
 run(void f(char *), char *s) {
   int pid;
   int xstatus;
+  uint64 t0 = rdtime();
 
   printf("test %s: ", s);
   if((pid = fork()) < 0) {
@@ -3137,16 +3724,145 @@ run(void f(char *), char *s) {
   } else {
     wait(&xstatus);
     if(xstatus != 0) 
-      printf("FAILED\n");
+      printf("FAILED (%lu ms)\n", msince(t0));
     else
-      printf("OK\n");
+      printf("OK (%lu ms)\n", msince(t0));
     return xstatus == 0;
   }
 }
 
+// The directory a test runs in under -p, so that tests running at
+// the same time don't trip over each other's file names.
+void
+pardir(char *dir, int i)
+{
+  dir[0] = 'p';
+  dir[1] = 't';
+  dir[2] = '0' + i / 10;
+  dir[3] = '0' + i % 10;
+  dir[4] = 0;
+}
+
+// Remove path and, if it's a directory, everything in it, so that
+// what a test leaves behind in its -p directory doesn't stop the
+// next round (-c, -C) from making the directory afresh.
+void
+rmtree(char *path)
+{
+  char buf[MAXPATH], *p;
+  struct dirent de;
+  struct stat st;
+  int fd;
+
+  if(stat(path, &st) == 0 && st.type == T_DIR &&
+     strlen(path) + 1 + DIRSIZ < sizeof(buf) &&
+     (fd = open(path, O_RDONLY)) >= 0){
+    strcpy(buf, path);
+    p = buf + strlen(buf);
+    *p++ = '/';
+    while(read(fd, &de, sizeof(de)) == sizeof(de)){
+      if(de.inum == 0 || strcmp(de.name, ".") == 0 || strcmp(de.name, "..") == 0)
+        continue;
+      memmove(p, de.name, DIRSIZ);
+      p[DIRSIZ] = 0;
+      rmtree(buf);
+    }
+    close(fd);
+  }
+  unlink(path);
+}
+
+#define MAXPAR 8
+
+// Run the tests not marked SERIAL, up to npar at a time, each in
+// its own process and directory; then the SERIAL ones, one by one.
+// A test's line is printed when it finishes, with its wall time.
+int
+runparallel(struct test *tests, char *justone, int continuous, int npar) {
+  struct {
+    int pid;
+    struct test *t;
+    uint64 t0;
+  } slot[MAXPAR];
+  int ntests = 0, running = 0, failed = 0;
+  int pid, xstatus, i;
+  char dir[8];
+  struct test *t;
+
+  for(i = 0; i < npar; i++)
+    slot[i].pid = 0;
+  t = tests;
+  while(t->s != 0 || running > 0){
+    if(t->s != 0 && running < npar && !(failed && continuous != 2)){
+      if(t->serial || (justone != 0 && strcmp(t->s, justone) != 0)){
+        t++;
+        continue;
+      }
+      for(i = 0; slot[i].pid != 0; i++)
+        ;
+      pardir(dir, t - tests);
+      rmtree(dir);
+      slot[i].t = t;
+      slot[i].t0 = rdtime();
+      if((pid = fork()) < 0){
+        printf("runtest: fork error\n");
+        exit(1);
+      }
+      if(pid == 0){
+        if(mkdir(dir) < 0 || chdir(dir) < 0){
+          printf("test %s: cannot make %s\n", t->s, dir);
+          exit(1);
+        }
+        t->f(t->s);
+        exit(0);
+      }
+      slot[i].pid = pid;
+      running++;
+      ntests++;
+      t++;
+      continue;
+    }
+    if(running == 0)
+      break;
+    if((pid = wait(&xstatus)) < 0)
+      break;
+    for(i = 0; i < npar && slot[i].pid != pid; i++)
+      ;
+    if(i == npar)
+      continue;
+    printf("test %s: %s (%lu ms)\n", slot[i].t->s, xstatus ? "FAILED" : "OK",
+           msince(slot[i].t0));
+    if(xstatus)
+      failed = 1;
+    pardir(dir, slot[i].t - tests);
+    rmtree(dir);
+    slot[i].pid = 0;
+    running--;
+  }
+  if(failed && continuous != 2){
+    printf("SOME TESTS FAILED\n");
+    return -1;
+  }
+
+  for(t = tests; t->s != 0; t++) {
+    if(t->serial && (justone == 0 || strcmp(t->s, justone) == 0)) {
+      ntests++;
+      if(!run(t->f, t->s)){
+        if(continuous != 2){
+          printf("SOME TESTS FAILED\n");
+          return -1;
+        }
+      }
+    }
+  }
+  return ntests;
+}
+
 int
-runtests(struct test *tests, char *justone, int continuous) {
+runtests(struct test *tests, char *justone, int continuous, int npar) {
   int ntests = 0;
+  if(npar > 1)
+    return runparallel(tests, justone, continuous, npar);
   for (struct test *t = tests; t->s != 0; t++) {
     if((justone == 0) || strcmp(t->s, justone) == 0) {
       ntests++;
@@ -3180,14 +3896,14 @@ countfree()
 }
 
 int
-drivetests(int quick, int continuous, char *justone) {
+drivetests(int quick, int continuous, char *justone, int npar) {
   do {
     printf("usertests starting\n");
     int free0 = countfree();
     int free1 = 0;
     int ntests = 0;
     int n;
-    n = runtests(quicktests, justone, continuous);
+    n = runtests(quicktests, justone, continuous, npar);
     if (n < 0) {
       if(continuous != 2) {
         return 1;
@@ -3198,7 +3914,7 @@ drivetests(int quick, int continuous, char *justone) {
     if(!quick) {
       if (justone == 0)
         printf("usertests slow tests starting\n");
-      n = runtests(slowtests, justone, continuous);
+      n = runtests(slowtests, justone, continuous, npar);
       if (n < 0) {
         if(continuous != 2) {
           return 1;
@@ -3226,8 +3942,21 @@ main(int argc, char *argv[])
 {
   int continuous = 0;
   int quick = 0;
+  int npar = 1;
   char *justone = 0;
 
+  // -p n runs up to n tests at once (see runparallel()); it can
+  // come before any of the other arguments.
+  if(argc >= 3 && strcmp(argv[1], "-p") == 0){
+    npar = atoi(argv[2]);
+    if(npar < 1 || npar > MAXPAR){
+      printf("usertests: -p takes 1..%d\n", MAXPAR);
+      exit(1);
+    }
+    argv[2] = argv[0];
+    argv += 2;
+    argc -= 2;
+  }
   if(argc == 2 && strcmp(argv[1], "-q") == 0){
     quick = 1;
   } else if(argc == 2 && strcmp(argv[1], "-c") == 0){
@@ -3237,10 +3966,10 @@ main(int argc, char *argv[])
   } else if(argc == 2 && argv[1][0] != '-'){
     justone = argv[1];
   } else if(argc > 1){
-    printf("Usage: usertests [-c] [-C] [-q] [testname]\n");
+    printf("Usage: usertests [-p n] [-c] [-C] [-q] [testname]\n");
     exit(1);
   }
-  if (drivetests(quick, continuous, justone)) {
+  if (drivetests(quick, continuous, justone, npar)) {
     exit(1);
   }
   printf("ALL TESTS PASSED\n");
@@ -9,9 +9,11 @@ print "#include \"kernel/syscall.h\"\n";
 sub entry {
     my $prefix = "sys_";
     my $name = shift;
-    if ($name eq "sbrk") {
+    if ($name eq "sbrk" || $name eq "getpid" || $name eq "uptime") {
         # sbrk has a sys_sbrk stub; user-level sbrk/sbrklazy
         # are implemented in user space on top of this.
+        # getpid/uptime likewise get sys_ stubs; ulib.c reads
+        # the USYSCALL page instead of trapping.
         print ".global ${prefix}${name}\n";
         print "${prefix}${name}:\n";
     } else {
@@ -45,3 +47,20 @@ entry("sbrk");
 entry("pause");
 entry("uptime");
 entry("set_llm_advice");
+entry("uring_setup");
+entry("uring_enter");
+entry("getsysstat");
+entry("clone");
+entry("futex");
+entry("setaffinity");
+entry("setrealtime");
+entry("setschedgroup");
+entry("getpriority");
+entry("setpriority");
+entry("setschedpolicy");
+entry("settimeslice");
+entry("setgang");
+entry("setstarvebound");
+entry("yield");
+entry("lseek");
+entry("pipe2");
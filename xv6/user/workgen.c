@@ -0,0 +1,476 @@
+// user/workgen.c
+// Synthetic workload generator. Where cpubound, iobound and mixed
+// each hard-code one shape, workgen runs workers that follow a
+// small script of phases, timing each kind of phase, so bursty
+// production-like mixes can be put together without a new binary.
+//
+// Usage:
+//   workgen [-l label] [-v] script      // read the script from a file
+//   workgen [-l label] [-v] -e text...  // script on the command line
+//
+// After -e, the rest of the command line is the script, with ','
+// separating lines and ':' allowed between words as well as
+// spaces. sh splits on ';' and passes at most a few arguments, so
+// write it as one word there, or use a file for longer scripts.
+//
+// Script lines (blank lines and # comments are ignored):
+//
+//   worker <name> [count]   start a new kind of worker; count copies
+//                           of it run (default 1)
+//   repeat <n>              run this worker's phases n times (default 1)
+//   cpu <iters>             a CPU burst of iters loop iterations
+//   pause <ticks>           pause(ticks)
+//   write <blocks>          write blocks 1K blocks to the worker's file
+//   read <blocks>           read blocks 1K blocks back from it
+//   pipe <rounds>           1-byte round trips with a child over pipes
+//   fork <n> <iters>        fork n children that each burn iters, and
+//                           wait for them
+//
+// Phases run in order, repeat times over. Each worker has its own
+// file, which wraps around after 64 blocks. For example:
+//
+//   workgen -e worker:web:3,repeat:20,cpu:200000,pause:2,write:2,worker:batch,cpu:50000000
+//
+// Per worker, timed with rdtime(): response (fork() to its first
+// phase), turnaround (fork() to its last) and the total time spent
+// in each kind of phase; for pause, also how far past the requested
+// ticks it woke. -v prints a WORKER line per worker; the RESULT line
+// has averages over all workers, in microseconds:
+//
+//   RESULT bench=workgen label=<l> workers=<n> elapsed_us=<t> resp_avg_us=.. resp_max_us=..
+//     turn_avg_us=.. turn_max_us=.. cpu_avg_us=.. pause_avg_us=.. pause_late_avg_us=..
+//     write_avg_us=.. read_avg_us=.. pipe_avg_us=.. fork_avg_us=..
+//
+// (all on one line).
+
+#include "kernel/types.h"
+#include "kernel/stat.h"
+#include "kernel/fcntl.h"
+#include "kernel/fs.h"
+#include "user/user.h"
+
+#define MAXKINDS   8               // worker lines
+#define MAXPHASES  32              // phases per worker kind
+#define MAXWORKERS 12              // processes, all kinds together
+#define WRAP       64              // blocks in a worker's file
+#define TICK       (TIMEBASE_HZ / 10)  // one timer tick of rdtime()
+#define LINESZ     128
+
+enum { CPU, PAUSE, WRITE, READ, PIPE, FORK, NPHASE };
+
+static char *phasename[NPHASE] = {
+  "cpu", "pause", "write", "read", "pipe", "fork",
+};
+
+struct phase {
+  int op;
+  int arg, arg2;
+};
+
+struct kind {
+  char name[16];
+  int count;
+  int repeat;
+  int nphase;
+  struct phase phase[MAXPHASES];
+};
+
+static struct kind kinds[MAXKINDS];
+static int nkinds;
+
+// What a worker sends back through the pipe. Small enough that
+// MAXWORKERS of them fit in a pipe, so writes never interleave.
+struct rec {
+  ushort kind;
+  ushort pid;
+  uint resp;                       // microseconds
+  uint turn;
+  uint t[NPHASE];
+  uint late;                       // pause() overshoot
+};
+
+static char blk[BSIZE];
+static volatile int sink;
+
+static void
+burn(int n)
+{
+  for(int i = 0; i < n; i++)
+    sink += i;
+}
+
+static uint
+us(uint64 t)
+{
+  return t / (TIMEBASE_HZ / 1000000);
+}
+
+static int
+isnum(char *s)
+{
+  if(*s == 0)
+    return 0;
+  for(; *s; s++)
+    if(*s < '0' || *s > '9')
+      return 0;
+  return 1;
+}
+
+static int
+issep(char c)
+{
+  return c == ' ' || c == '\t' || c == '\n' || c == '\r' || c == ':';
+}
+
+// Split line into at most max words, separated by spaces or ':'.
+static int
+words(char *line, char **w, int max)
+{
+  int n = 0;
+
+  for(;;){
+    while(issep(*line))
+      *line++ = 0;
+    if(*line == 0 || *line == '#' || n == max)
+      return n;
+    w[n++] = line;
+    while(*line && !issep(*line))
+      line++;
+  }
+}
+
+// Add one script line; 0, or -1 with a message if it's bad.
+static int
+parseline(char *line, int lineno)
+{
+  char *w[4];
+  int n, op;
+  struct kind *k;
+
+  if((n = words(line, w, 4)) == 0)
+    return 0;
+  if(strcmp(w[0], "worker") == 0){
+    if(n < 2 || n > 3 || (n == 3 && !isnum(w[2])) || nkinds == MAXKINDS){
+      fprintf(2, "workgen: line %d: worker <name> [count], at most %d\n",
+              lineno, MAXKINDS);
+      return -1;
+    }
+    k = &kinds[nkinds++];
+    if(strlen(w[1]) >= sizeof(k->name)){
+      fprintf(2, "workgen: line %d: worker name too long\n", lineno);
+      return -1;
+    }
+    strcpy(k->name, w[1]);
+    k->count = n == 3 ? atoi(w[2]) : 1;
+    k->repeat = 1;
+    k->nphase = 0;
+    return 0;
+  }
+  if(nkinds == 0){
+    fprintf(2, "workgen: line %d: %s before any worker\n", lineno, w[0]);
+    return -1;
+  }
+  k = &kinds[nkinds - 1];
+  if(strcmp(w[0], "repeat") == 0){
+    if(n != 2 || !isnum(w[1])){
+      fprintf(2, "workgen: line %d: repeat <n>\n", lineno);
+      return -1;
+    }
+    k->repeat = atoi(w[1]);
+    return 0;
+  }
+  for(op = 0; op < NPHASE; op++)
+    if(strcmp(w[0], phasename[op]) == 0)
+      break;
+  if(op == NPHASE){
+    fprintf(2, "workgen: line %d: unknown phase %s\n", lineno, w[0]);
+    return -1;
+  }
+  if(n != (op == FORK ? 3 : 2) || !isnum(w[1]) || (op == FORK && !isnum(w[2]))){
+    fprintf(2, "workgen: line %d: %s %s\n", lineno, w[0],
+            op == FORK ? "<n> <iters>" : "<n>");
+    return -1;
+  }
+  if(k->nphase == MAXPHASES){
+    fprintf(2, "workgen: line %d: more than %d phases\n", lineno, MAXPHASES);
+    return -1;
+  }
+  k->phase[k->nphase].op = op;
+  k->phase[k->nphase].arg = atoi(w[1]);
+  k->phase[k->nphase].arg2 = op == FORK ? atoi(w[2]) : 0;
+  k->nphase++;
+  return 0;
+}
+
+static int
+parsefile(char *path)
+{
+  char line[LINESZ];
+  int fd, n, lineno = 0;
+
+  if((fd = open(path, O_RDONLY)) < 0){
+    fprintf(2, "workgen: cannot open %s\n", path);
+    return -1;
+  }
+  while((n = readline(fd, line, sizeof(line))) > 0)
+    if(parseline(line, ++lineno) < 0){
+      close(fd);
+      return -1;
+    }
+  close(fd);
+  return n;
+}
+
+// The script given after -e: argv's words, lines split at ','.
+static int
+parseargs(int argc, char **argv)
+{
+  static char text[512];
+  int lineno = 0, len = 0;
+  char *p, *line;
+
+  for(int i = 0; i < argc; i++){
+    if(len + strlen(argv[i]) + 2 > sizeof(text)){
+      fprintf(2, "workgen: -e script too long\n");
+      return -1;
+    }
+    strcpy(text + len, argv[i]);
+    len += strlen(argv[i]);
+    text[len++] = ' ';
+    text[len] = 0;
+  }
+  for(line = text; line; line = p){
+    if((p = strchr(line, ',')) != 0)
+      *p++ = 0;
+    if(parseline(line, ++lineno) < 0)
+      return -1;
+  }
+  return 0;
+}
+
+// 1-byte round trips with a child that echoes them back.
+static void
+pingpong(int rounds)
+{
+  int ping[2], pong[2];
+  char c = 0;
+
+  if(pipe(ping) < 0 || pipe(pong) < 0){
+    fprintf(2, "workgen: pipe failed\n");
+    exit(1);
+  }
+  if(fork() == 0){
+    close(ping[1]);
+    close(pong[0]);
+    while(read(ping[0], &c, 1) == 1)
+      write(pong[1], &c, 1);
+    exit(0);
+  }
+  close(ping[0]);
+  close(pong[1]);
+  for(int i = 0; i < rounds; i++){
+    write(ping[1], &c, 1);
+    read(pong[0], &c, 1);
+  }
+  close(ping[1]);
+  close(pong[0]);
+  wait(0);
+}
+
+static void
+worker(int ki, uint64 forked, int fd)
+{
+  struct kind *k = &kinds[ki];
+  struct rec r;
+  uint64 t[NPHASE], late = 0;
+  char name[16] = "wg.";
+  int file, fsize = 0, woff = 0, roff = 0;
+
+  r.resp = us(rdtime() - forked);
+  memset(t, 0, sizeof(t));
+
+  // wg.<pid>, this worker's file.
+  int pid = getpid(), n = 3;
+  for(int d = 10000; d > 0; d /= 10)
+    if(pid >= d || d == 1)
+      name[n++] = '0' + pid / d % 10;
+  name[n] = 0;
+  if((file = open(name, O_CREATE | O_TRUNC | O_RDWR)) < 0){
+    fprintf(2, "workgen: cannot create %s\n", name);
+    exit(1);
+  }
+  memset(blk, 'w', sizeof(blk));
+
+  for(int rep = 0; rep < k->repeat; rep++){
+    for(int p = 0; p < k->nphase; p++){
+      struct phase *ph = &k->phase[p];
+      uint64 t0 = rdtime();
+      switch(ph->op){
+      case CPU:
+        burn(ph->arg);
+        break;
+      case PAUSE:
+        pause(ph->arg);
+        uint64 slept = rdtime() - t0;
+        if(slept > (uint64)ph->arg * TICK)
+          late += slept - (uint64)ph->arg * TICK;
+        break;
+      case WRITE:
+        for(int b = 0; b < ph->arg; b++){
+          if(woff == WRAP)
+            woff = 0;
+          lseek(file, woff * BSIZE, SEEK_SET);
+          write(file, blk, BSIZE);
+          if(++woff > fsize)
+            fsize = woff;
+        }
+        break;
+      case READ:
+        for(int b = 0; b < ph->arg && fsize > 0; b++){
+          if(roff >= fsize)
+            roff = 0;
+          lseek(file, roff * BSIZE, SEEK_SET);
+          read(file, blk, BSIZE);
+          roff++;
+        }
+        break;
+      case PIPE:
+        pingpong(ph->arg);
+        break;
+      case FORK:
+        for(int c = 0; c < ph->arg; c++){
+          int cpid = fork();
+          if(cpid == 0){
+            burn(ph->arg2);
+            exit(0);
+          }
+          if(cpid < 0)
+            break;
+        }
+        while(wait(0) > 0)
+          ;
+        break;
+      }
+      t[ph->op] += rdtime() - t0;
+    }
+  }
+  close(file);
+  unlink(name);
+
+  r.turn = us(rdtime() - forked);
+  for(int i = 0; i < NPHASE; i++)
+    r.t[i] = us(t[i]);
+  r.late = us(late);
+  r.kind = ki;
+  r.pid = getpid();
+  write(fd, &r, sizeof(r));
+  exit(0);
+}
+
+static void
+usage(void)
+{
+  fprintf(2, "usage: workgen [-l label] [-v] script | -e line,line,...\n");
+  exit(1);
+}
+
+int
+main(int argc, char *argv[])
+{
+  char *label = "-";
+  int verbose = 0, i, k, total = 0, done = 0;
+  int fds[2];
+  uint64 start, elapsed;
+  uint64 respsum = 0, turnsum = 0, latesum = 0, tsum[NPHASE];
+  uint respmax = 0, turnmax = 0;
+  struct rec r;
+
+  for(i = 1; i < argc && argv[i][0] == '-'; i++){
+    if(strcmp(argv[i], "-v") == 0)
+      verbose = 1;
+    else if(strcmp(argv[i], "-l") == 0 && i + 1 < argc)
+      label = argv[++i];
+    else if(strcmp(argv[i], "-e") == 0 && i + 1 < argc){
+      if(parseargs(argc - i - 1, argv + i + 1) < 0)
+        exit(1);
+      i = argc;
+    } else
+      usage();
+  }
+  if(i < argc){
+    if(i + 1 != argc || nkinds > 0)
+      usage();
+    if(parsefile(argv[i]) < 0)
+      exit(1);
+  }
+  if(nkinds == 0)
+    usage();
+  for(k = 0; k < nkinds; k++)
+    total += kinds[k].count;
+  if(total < 1 || total > MAXWORKERS){
+    fprintf(2, "workgen: need 1..%d workers in all\n", MAXWORKERS);
+    exit(1);
+  }
+
+  if(pipe(fds) < 0){
+    fprintf(2, "workgen: pipe failed\n");
+    exit(1);
+  }
+  start = rdtime();
+  for(k = 0; k < nkinds; k++){
+    for(i = 0; i < kinds[k].count; i++){
+      uint64 t = rdtime();
+      int pid = fork();
+      if(pid < 0){
+        fprintf(2, "workgen: fork failed\n");
+        exit(1);
+      }
+      if(pid == 0){
+        close(fds[0]);
+        worker(k, t, fds[1]);
+      }
+    }
+  }
+  close(fds[1]);
+
+  memset(tsum, 0, sizeof(tsum));
+  while(read(fds[0], &r, sizeof(r)) == sizeof(r)){
+    done++;
+    respsum += r.resp;
+    turnsum += r.turn;
+    latesum += r.late;
+    if(r.resp > respmax)
+      respmax = r.resp;
+    if(r.turn > turnmax)
+      turnmax = r.turn;
+    for(i = 0; i < NPHASE; i++)
+      tsum[i] += r.t[i];
+    if(verbose){
+      printf("WORKER bench=workgen pid=%d kind=%s resp_us=%d turn_us=%d",
+             r.pid, kinds[r.kind].name, r.resp, r.turn);
+      for(i = 0; i < NPHASE; i++)
+        printf(" %s_us=%d", phasename[i], r.t[i]);
+      printf(" pause_late_us=%d\n", r.late);
+    }
+  }
+  while(wait(0) > 0)
+    ;
+  elapsed = rdtime() - start;
+  close(fds[0]);
+  if(done == 0){
+    fprintf(2, "workgen: no worker finished\n");
+    exit(1);
+  }
+
+  printf("RESULT bench=workgen label=%s workers=%d elapsed_us=%d "
+         "resp_avg_us=%lu resp_max_us=%d turn_avg_us=%lu turn_max_us=%d",
+         label, done, us(elapsed), respsum / done, respmax,
+         turnsum / done, turnmax);
+  for(i = 0; i < NPHASE; i++){
+    printf(" %s_avg_us=%lu", phasename[i], tsum[i] / done);
+    if(i == PAUSE)
+      printf(" pause_late_avg_us=%lu", latesum / done);
+  }
+  printf("\n");
+  exit(0);
+}